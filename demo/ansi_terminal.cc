@@ -0,0 +1,622 @@
+#include "demo/ansi_terminal.h"
+
+namespace demo {
+
+/*
+ * Classes of character, as far as the parser is concerned.  Characters from
+ * 0x80 up are all 'hi', and are printed: the font has glyphs for them.
+ */
+enum AnsiClass : std::uint8_t {
+  ctl,  // C0 control
+  bel,  // BEL, which also ends strings
+  can,  // CAN or SUB, which cancel a sequence
+  esc,
+  imd,  // intermediate, 0x20-0x2F
+  dig,  // parameter digit
+  sep,  // parameter separator, ; or :
+  prv,  // private parameter marker, < = > ?
+  csi,  // [, which follows ESC to start a control sequence
+  str,  // P X ] ^ _, which follow ESC to start a string
+  fin,  // other final characters
+  del,
+  hi,
+
+  class_count,
+};
+
+static AnsiClass const char_classes[128] {
+  /* 00 */ ctl, ctl, ctl, ctl, ctl, ctl, ctl, bel,
+  /* 08 */ ctl, ctl, ctl, ctl, ctl, ctl, ctl, ctl,
+  /* 10 */ ctl, ctl, ctl, ctl, ctl, ctl, ctl, ctl,
+  /* 18 */ can, ctl, can, esc, ctl, ctl, ctl, ctl,
+  /* 20 */ imd, imd, imd, imd, imd, imd, imd, imd,
+  /* 28 */ imd, imd, imd, imd, imd, imd, imd, imd,
+  /* 30 */ dig, dig, dig, dig, dig, dig, dig, dig,
+  /* 38 */ dig, dig, sep, sep, prv, prv, prv, prv,
+  /* 40 */ fin, fin, fin, fin, fin, fin, fin, fin,
+  /* 48 */ fin, fin, fin, fin, fin, fin, fin, fin,
+  /* 50 */ str, fin, fin, fin, fin, fin, fin, fin,
+  /* 58 */ str, fin, fin, csi, fin, str, str, str,
+  /* 60 */ fin, fin, fin, fin, fin, fin, fin, fin,
+  /* 68 */ fin, fin, fin, fin, fin, fin, fin, fin,
+  /* 70 */ fin, fin, fin, fin, fin, fin, fin, fin,
+  /* 78 */ fin, fin, fin, fin, fin, fin, fin, del,
+};
+
+enum class AnsiState : std::uint8_t {
+  ground,
+  escape,
+  escape_imd,
+  csi_param,
+  csi_imd,
+  csi_ignore,
+  string,
+
+  count,
+};
+
+enum class AnsiAction : std::uint8_t {
+  none,
+  print,
+  execute,
+  clear,
+  collect,
+  add_param,
+  marker,
+  esc_dispatch,
+  csi_dispatch,
+};
+
+struct AnsiTransition {
+  AnsiAction action;
+  AnsiState next;
+};
+
+using A = AnsiAction;
+using S = AnsiState;
+
+static AnsiTransition const transitions[unsigned(S::count)][class_count] {
+  // Text and C0 controls.
+  {
+    {A::execute, S::ground},            // ctl
+    {A::execute, S::ground},            // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::print, S::ground},              // imd
+    {A::print, S::ground},              // dig
+    {A::print, S::ground},              // sep
+    {A::print, S::ground},              // prv
+    {A::print, S::ground},              // csi
+    {A::print, S::ground},              // str
+    {A::print, S::ground},              // fin
+    {A::none, S::ground},               // del
+    {A::print, S::ground},              // hi
+  },
+  // After ESC.
+  {
+    {A::execute, S::escape},            // ctl
+    {A::execute, S::escape},            // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::collect, S::escape_imd},        // imd
+    {A::esc_dispatch, S::ground},       // dig
+    {A::esc_dispatch, S::ground},       // sep
+    {A::esc_dispatch, S::ground},       // prv
+    {A::clear, S::csi_param},           // csi
+    {A::none, S::string},               // str
+    {A::esc_dispatch, S::ground},       // fin
+    {A::none, S::escape},               // del
+    {A::none, S::ground},               // hi
+  },
+  // After ESC and an intermediate, as in ESC ( B.
+  {
+    {A::execute, S::escape_imd},        // ctl
+    {A::execute, S::escape_imd},        // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::collect, S::escape_imd},        // imd
+    {A::esc_dispatch, S::ground},       // dig
+    {A::esc_dispatch, S::ground},       // sep
+    {A::esc_dispatch, S::ground},       // prv
+    {A::esc_dispatch, S::ground},       // csi
+    {A::esc_dispatch, S::ground},       // str
+    {A::esc_dispatch, S::ground},       // fin
+    {A::none, S::escape_imd},           // del
+    {A::none, S::ground},               // hi
+  },
+  // After CSI (ESC [), collecting parameters.
+  {
+    {A::execute, S::csi_param},         // ctl
+    {A::execute, S::csi_param},         // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::collect, S::csi_imd},           // imd
+    {A::add_param, S::csi_param},       // dig
+    {A::add_param, S::csi_param},       // sep
+    {A::marker, S::csi_param},          // prv
+    {A::csi_dispatch, S::ground},       // csi
+    {A::csi_dispatch, S::ground},       // str
+    {A::csi_dispatch, S::ground},       // fin
+    {A::none, S::csi_param},            // del
+    {A::none, S::ground},               // hi
+  },
+  // After an intermediate in a control sequence.
+  {
+    {A::execute, S::csi_imd},           // ctl
+    {A::execute, S::csi_imd},           // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::collect, S::csi_imd},           // imd
+    {A::none, S::csi_ignore},           // dig
+    {A::none, S::csi_ignore},           // sep
+    {A::none, S::csi_ignore},           // prv
+    {A::csi_dispatch, S::ground},       // csi
+    {A::csi_dispatch, S::ground},       // str
+    {A::csi_dispatch, S::ground},       // fin
+    {A::none, S::csi_imd},              // del
+    {A::none, S::ground},               // hi
+  },
+  // In a malformed control sequence, up to its final character.
+  {
+    {A::execute, S::csi_ignore},        // ctl
+    {A::execute, S::csi_ignore},        // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::none, S::csi_ignore},           // imd
+    {A::none, S::csi_ignore},           // dig
+    {A::none, S::csi_ignore},           // sep
+    {A::none, S::csi_ignore},           // prv
+    {A::none, S::ground},               // csi
+    {A::none, S::ground},               // str
+    {A::none, S::ground},               // fin
+    {A::none, S::csi_ignore},           // del
+    {A::none, S::ground},               // hi
+  },
+  // In an OSC, DCS, PM, APC or SOS string, which are all ignored, up
+  // to BEL or ST (ESC \\).
+  {
+    {A::none, S::string},               // ctl
+    {A::none, S::ground},               // bel
+    {A::none, S::ground},               // can
+    {A::clear, S::escape},              // esc
+    {A::none, S::string},               // imd
+    {A::none, S::string},               // dig
+    {A::none, S::string},               // sep
+    {A::none, S::string},               // prv
+    {A::none, S::string},               // csi
+    {A::none, S::string},               // str
+    {A::none, S::string},               // fin
+    {A::none, S::string},               // del
+    {A::none, S::string},               // hi
+  },
+};
+
+/*
+ * Palette mapping.  Palette entries are RGB with two bits per channel, red in
+ * the least significant bits.
+ */
+
+static Terminal::Pixel rgb(unsigned r, unsigned g, unsigned b) {
+  return Terminal::Pixel(r | (g << 2) | (b << 4));
+}
+
+// One of the 16 standard colors; 'n' has bits for red, green and blue.
+static Terminal::Pixel standard_color(unsigned n, bool bright) {
+  if (n == 0) return bright ? dk_gray : black;
+  unsigned const level = bright ? 3 : 2;
+  return rgb(n & 1 ? level : 0, n & 2 ? level : 0, n & 4 ? level : 0);
+}
+
+// One of the xterm 256 colors: the 16 standard colors, a 6x6x6 cube, and a
+// 24-step gray ramp.
+static Terminal::Pixel indexed_color(unsigned n) {
+  if (n < 16) return standard_color(n & 7, n >= 8);
+  if (n < 232) {
+    n -= 16;
+    auto const level = [](unsigned v) { return (v * 3 + 2) / 5; };
+    return rgb(level(n / 36), level(n / 6 % 6), level(n % 6));
+  }
+  auto const gray = ((n - 232) * 3 + 11) / 23;
+  return rgb(gray, gray, gray);
+}
+
+AnsiTerminal::AnsiTerminal(Terminal & term, Pixel fore, Pixel back)
+  : _term(term),
+    _default_fore(fore),
+    _default_back(back) {
+  reset();
+}
+
+void AnsiTerminal::reset() {
+  _state = std::uint8_t(S::ground);
+  _param_count = 0;
+  _private = false;
+  _intermediate = 0;
+
+  _sgr_fore = _default_fore;
+  _sgr_back = _default_back;
+  _fore_index = no_index;
+  _bold = _reverse = false;
+  update_colors();
+  _saved = { 0, 0, _sgr_fore, _sgr_back, _fore_index, false, false };
+
+  _term.set_scroll_region(0, _term.rasterizer.get_row_count() - 1);
+  _term.clear(_back);
+  _term.cursor_to(0, 0);
+}
+
+void AnsiTerminal::write(char const *s, unsigned count) {
+  auto const end = s + count;
+  while (s != end) {
+    if (_state == std::uint8_t(S::ground)) {
+      // Fast path: pass along any run of printable characters at once.
+      auto run = s;
+      while (run != end) {
+        auto const c = static_cast<unsigned char>(*run);
+        if (c < 0x20 || c == 0x7F) break;
+        ++run;
+      }
+      if (run != s) {
+        _term.type_run(_fore, _back, s, unsigned(run - s));
+        s = run;
+        continue;
+      }
+    }
+    step(static_cast<unsigned char>(*s++));
+  }
+}
+
+void AnsiTerminal::write(char const *s) {
+  auto const start = s;
+  while (*s) ++s;
+  write(start, unsigned(s - start));
+}
+
+void AnsiTerminal::write(char c) {
+  step(static_cast<unsigned char>(c));
+}
+
+void AnsiTerminal::step(unsigned char c) {
+  auto const cls = c < 0x80 ? char_classes[c] : hi;
+  auto const t = transitions[_state][cls];
+  _state = std::uint8_t(t.next);
+
+  switch (t.action) {
+    case A::none:
+      return;
+
+    case A::print:
+      _term.type_raw(_fore, _back, char(c));
+      return;
+
+    case A::execute:
+      execute(c);
+      return;
+
+    case A::clear:
+      _param_count = 0;
+      _private = false;
+      _intermediate = 0;
+      return;
+
+    case A::collect:
+      _intermediate = char(c);
+      return;
+
+    case A::add_param:
+      if (_param_count == 0) {
+        _params[0] = 0;
+        _param_count = 1;
+      }
+      if (c == ';' || c == ':') {
+        if (_param_count < max_params) _params[_param_count++] = 0;
+      } else {
+        auto & p = _params[_param_count - 1];
+        auto const v = p * 10u + (c - '0');
+        p = v > 0xFFFF ? 0xFFFF : std::uint16_t(v);
+      }
+      return;
+
+    case A::marker:
+      _private = true;
+      return;
+
+    case A::esc_dispatch:
+      esc_dispatch(c);
+      return;
+
+    case A::csi_dispatch:
+      csi_dispatch(c);
+      return;
+  }
+}
+
+void AnsiTerminal::execute(unsigned char c) {
+  auto const cols = _term.rasterizer.get_col_count();
+
+  switch (c) {
+    case '\b':
+      if (_term.t_col) _term.cursor_to(_term.t_col - 1, _term.t_row);
+      return;
+
+    case '\t': {
+      auto const next = (_term.t_col / 8 + 1) * 8;
+      _term.cursor_to(next < cols ? next : cols - 1, _term.t_row);
+      return;
+    }
+
+    case '\n':
+    case '\v':
+    case '\f':
+      _term.line_feed(_back);
+      return;
+
+    case '\r':
+      _term.cursor_to(0, _term.t_row);
+      return;
+
+    default:
+      return;
+  }
+}
+
+void AnsiTerminal::esc_dispatch(unsigned char c) {
+  // Sequences with intermediates select character sets and the like, which
+  // don't apply here.
+  if (_intermediate) return;
+
+  switch (c) {
+    case 'D':  // IND
+      _term.line_feed(_back);
+      return;
+
+    case 'E':  // NEL
+      _term.cursor_to(0, _term.t_row);
+      _term.line_feed(_back);
+      return;
+
+    case 'M':  // RI
+      _term.reverse_line_feed(_back);
+      return;
+
+    case '7':  // DECSC
+      _saved = { _term.t_row, _term.t_col, _sgr_fore, _sgr_back,
+                 _fore_index, _bold, _reverse };
+      return;
+
+    case '8':  // DECRC
+      _sgr_fore = _saved.sgr_fore;
+      _sgr_back = _saved.sgr_back;
+      _fore_index = _saved.fore_index;
+      _bold = _saved.bold;
+      _reverse = _saved.reverse;
+      update_colors();
+      _term.cursor_to(_saved.col, _saved.row);
+      return;
+
+    case 'c':  // RIS
+      reset();
+      return;
+
+    default:
+      return;
+  }
+}
+
+unsigned AnsiTerminal::param(unsigned n, unsigned otherwise) const {
+  return n < _param_count && _params[n] ? _params[n] : otherwise;
+}
+
+void AnsiTerminal::csi_dispatch(unsigned char c) {
+  // Private sequences (mostly DEC modes) and those with intermediates aren't
+  // supported.
+  if (_private || _intermediate) return;
+
+  auto const rows = _term.rasterizer.get_row_count();
+  auto const cols = _term.rasterizer.get_col_count();
+  auto const row = _term.t_row;
+  auto const col = _term.t_col;
+
+  // Counts for the cursor movement and line operations below.  Counts past
+  // the size of the screen all have the same effect.
+  auto n = param(0, 1);
+  if (n > rows) n = rows;
+  auto const n_cols = param(0, 1) < cols ? param(0, 1) : cols;
+
+  switch (c) {
+    case 'A':  // CUU
+      _term.cursor_to(col, row > n ? row - n : 0);
+      return;
+
+    case 'B':  // CUD
+    case 'e':  // VPR
+      _term.cursor_to(col, row + n);
+      return;
+
+    case 'C':  // CUF
+    case 'a':  // HPR
+      _term.cursor_to(col + n_cols, row);
+      return;
+
+    case 'D':  // CUB
+      _term.cursor_to(col > n_cols ? col - n_cols : 0, row);
+      return;
+
+    case 'E':  // CNL
+      _term.cursor_to(0, row + n);
+      return;
+
+    case 'F':  // CPL
+      _term.cursor_to(0, row > n ? row - n : 0);
+      return;
+
+    case 'G':  // CHA
+    case '`':  // HPA
+      _term.cursor_to(param(0, 1) - 1, row);
+      return;
+
+    case 'H':  // CUP
+    case 'f':  // HVP
+      _term.cursor_to(param(1, 1) - 1, param(0, 1) - 1);
+      return;
+
+    case 'd':  // VPA
+      _term.cursor_to(col, param(0, 1) - 1);
+      return;
+
+    case 'J':  // ED
+      switch (param(0, 0)) {
+        case 0:
+          _term.erase(row, col, cols, _back);
+          for (unsigned r = row + 1; r < rows; ++r) {
+            _term.erase(r, 0, cols, _back);
+          }
+          return;
+
+        case 1:
+          for (unsigned r = 0; r < row; ++r) _term.erase(r, 0, cols, _back);
+          _term.erase(row, 0, col + 1, _back);
+          return;
+
+        default:
+          _term.clear(_back);
+          return;
+      }
+
+    case 'K':  // EL
+      switch (param(0, 0)) {
+        case 0: _term.erase(row, col, cols, _back); return;
+        case 1: _term.erase(row, 0, col + 1, _back); return;
+        default: _term.erase(row, 0, cols, _back); return;
+      }
+
+    case 'X':  // ECH
+      _term.erase(row, col, col + n_cols, _back);
+      return;
+
+    case 'L':  // IL
+    case 'M':  // DL
+      // Lines only move within the scroll region, and only when the cursor
+      // is in it.
+      if (row < _term.get_scroll_top() || row > _term.get_scroll_bottom()) {
+        return;
+      }
+      for (unsigned i = 0; i < n; ++i) {
+        if (c == 'L') {
+          _term.scroll_down(row, _term.get_scroll_bottom(), _back);
+        } else {
+          _term.scroll_up(row, _term.get_scroll_bottom(), _back);
+        }
+      }
+      _term.cursor_to(0, row);
+      return;
+
+    case 'S':  // SU
+      for (unsigned i = 0; i < n; ++i) _term.scroll(_back);
+      return;
+
+    case 'T':  // SD
+      for (unsigned i = 0; i < n; ++i) {
+        _term.scroll_down(_term.get_scroll_top(), _term.get_scroll_bottom(),
+                          _back);
+      }
+      return;
+
+    case 'm':  // SGR
+      select_graphic_rendition();
+      return;
+
+    case 'r':  // DECSTBM
+      _term.set_scroll_region(param(0, 1) - 1, param(1, rows) - 1);
+      _term.cursor_to(0, 0);
+      return;
+
+    case 's':  // SCOSC
+      esc_dispatch('7');
+      return;
+
+    case 'u':  // SCORC
+      esc_dispatch('8');
+      return;
+
+    default:
+      return;
+  }
+}
+
+void AnsiTerminal::select_graphic_rendition() {
+  // No parameters means 0.
+  if (_param_count == 0) _params[_param_count++] = 0;
+
+  for (unsigned i = 0; i < _param_count; ++i) {
+    auto const p = _params[i];
+
+    if (p == 0) {
+      _sgr_fore = _default_fore;
+      _sgr_back = _default_back;
+      _fore_index = no_index;
+      _bold = _reverse = false;
+    } else if (p == 1) {
+      _bold = true;
+    } else if (p == 7) {
+      _reverse = true;
+    } else if (p == 22) {
+      _bold = false;
+    } else if (p == 27) {
+      _reverse = false;
+    } else if (p >= 30 && p <= 37) {
+      _sgr_fore = standard_color(p - 30, false);
+      _fore_index = p - 30;
+    } else if (p >= 40 && p <= 47) {
+      _sgr_back = standard_color(p - 40, false);
+    } else if (p >= 90 && p <= 97) {
+      _sgr_fore = standard_color(p - 90, true);
+      _fore_index = no_index;
+    } else if (p >= 100 && p <= 107) {
+      _sgr_back = standard_color(p - 100, true);
+    } else if (p == 39) {
+      _sgr_fore = _default_fore;
+      _fore_index = no_index;
+    } else if (p == 49) {
+      _sgr_back = _default_back;
+    } else if (p == 38 || p == 48) {
+      // Extended colors: 5;n for the 256-color palette, or 2;r;g;b.
+      Pixel color;
+      if (param(i + 1, 0) == 5) {
+        color = indexed_color(param(i + 2, 0) & 0xFF);
+        i += 2;
+      } else if (param(i + 1, 0) == 2) {
+        color = rgb(param(i + 2, 0) >> 6 & 3,
+                    param(i + 3, 0) >> 6 & 3,
+                    param(i + 4, 0) >> 6 & 3);
+        i += 4;
+      } else {
+        break;
+      }
+      if (p == 38) {
+        _sgr_fore = color;
+        _fore_index = no_index;
+      } else {
+        _sgr_back = color;
+      }
+    }
+  }
+
+  update_colors();
+}
+
+void AnsiTerminal::update_colors() {
+  auto fore = _bold && _fore_index != no_index
+            ? standard_color(_fore_index, true)
+            : _sgr_fore;
+  auto back = _sgr_back;
+  if (_reverse) {
+    auto const t = fore;
+    fore = back;
+    back = t;
+  }
+  _fore = fore;
+  _back = back;
+}
+
+}  // namespace demo
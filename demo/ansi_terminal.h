@@ -0,0 +1,86 @@
+#ifndef DEMO_ANSI_TERMINAL_H
+#define DEMO_ANSI_TERMINAL_H
+
+#include <cstdint>
+
+#include "demo/terminal.h"
+
+namespace demo {
+
+/*
+ * Interprets a stream of output for a VT100-style terminal -- text mixed with
+ * ANSI escape sequences -- and applies it to a Terminal.
+ *
+ * Supported:
+ *  - C0 controls: BS, HT, LF, VT, FF, CR.  (LF does not imply CR.)
+ *  - ESC D, E, M, 7, 8 and c.
+ *  - CSI cursor movement: A-H, a, d, e, f and `.
+ *  - CSI J, K and X to erase, and L, M, S and T to insert, delete and scroll
+ *    lines.
+ *  - CSI r, to set the scroll region, and s and u, to save and restore the
+ *    cursor.
+ *  - CSI m (SGR): bold, reverse, and the 8, 16, 256 and 24-bit color forms,
+ *    mapped onto the 64-color palette.  Bold brightens the standard colors.
+ * Everything else, including DEC private modes and OSC strings, is parsed
+ * and ignored.
+ *
+ * The parser follows the usual DEC state machine, driven by a table indexed
+ * by state and character class.  Printable text is the common case, so
+ * write() picks out runs of it and hands them to the Terminal in one go.
+ */
+class AnsiTerminal {
+public:
+  using Pixel = Terminal::Pixel;
+
+  AnsiTerminal(Terminal &, Pixel fore = lt_gray, Pixel back = black);
+
+  void write(char c);
+  void write(char const *s, unsigned count);
+  void write(char const *s);
+
+  // Returns to the state after construction: default colors, no scroll
+  // region, a clear screen and the cursor at the top left.
+  void reset();
+
+private:
+  static constexpr unsigned max_params = 16;
+
+  Terminal & _term;
+  Pixel const _default_fore, _default_back;
+
+  std::uint8_t _state;  // See ansi_terminal.cc.
+  std::uint16_t _params[max_params];
+  unsigned _param_count;
+  bool _private;
+  char _intermediate;
+
+  // Graphic rendition, and the colors it currently comes to.  When the
+  // foreground is one of the eight standard colors, _fore_index says which,
+  // so that bold can brighten it.
+  static constexpr std::uint8_t no_index = 0xFF;
+  Pixel _sgr_fore, _sgr_back;
+  std::uint8_t _fore_index;
+  bool _bold, _reverse;
+  Pixel _fore, _back;
+
+  struct Saved {
+    unsigned row, col;
+    Pixel sgr_fore, sgr_back;
+    std::uint8_t fore_index;
+    bool bold, reverse;
+  } _saved;
+
+  void step(unsigned char c);
+  void execute(unsigned char c);
+  void esc_dispatch(unsigned char c);
+  void csi_dispatch(unsigned char c);
+  void select_graphic_rendition();
+  void update_colors();
+
+  // The n'th parameter, or 'otherwise' if it's absent or zero.
+  unsigned param(unsigned n, unsigned otherwise) const;
+};
+
+}  // namespace demo
+
+#endif  // DEMO_ANSI_TERMINAL_H
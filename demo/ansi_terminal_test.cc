@@ -0,0 +1,358 @@
+/*
+ * Host test for AnsiTerminal, driving a Terminal on a mock Text_10x16 and
+ * checking what ends up on the screen.
+ *
+ * Besides the sequences themselves, this checks that the fast path in
+ * write(), which hands runs of text to the Terminal in one go, does exactly
+ * what feeding the same bytes one at a time through write(char) does, and
+ * that sequences split across calls to write() still work.
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "demo/ansi_terminal.h"
+
+using demo::AnsiTerminal;
+using demo::Terminal;
+using Pixel = Terminal::Pixel;
+
+// A small screen, so expected rows are easy to write out: 10 columns, 4 rows.
+static constexpr unsigned width = 100, height = 64, cols = 10, rows = 4;
+
+static unsigned failures;
+
+static void expect(bool ok, char const * test, char const * what) {
+  if (!ok) {
+    std::printf("FAIL: %s: %s\n", test, what);
+    ++failures;
+  }
+}
+
+static std::string screen_row(Terminal const & t, unsigned row) {
+  auto const fb_row = t.rasterizer.framebuffer_row(row);
+  std::string s;
+  for (unsigned col = 0; col < cols; ++col) {
+    s += t.rasterizer.char_at(col, fb_row);
+  }
+  return s;
+}
+
+static void expect_rows(Terminal const & t, char const * const (&text)[rows],
+                        char const * test) {
+  for (unsigned row = 0; row < rows; ++row) {
+    auto const got = screen_row(t, row);
+    if (got != text[row]) {
+      std::printf("FAIL: %s: row %u is \"%s\", expected \"%s\"\n",
+                  test, row, got.c_str(), text[row]);
+      ++failures;
+    }
+  }
+}
+
+static void expect_cursor(Terminal const & t, unsigned col, unsigned row,
+                          char const * test) {
+  if (t.t_col != col || t.t_row != row) {
+    std::printf("FAIL: %s: cursor at %u,%u, expected %u,%u\n",
+                test, t.t_col, t.t_row, col, row);
+    ++failures;
+  }
+}
+
+static Pixel fore_at(Terminal const & t, unsigned col, unsigned row) {
+  return t.rasterizer.fore_at(col, t.rasterizer.framebuffer_row(row));
+}
+
+static Pixel back_at(Terminal const & t, unsigned col, unsigned row) {
+  return t.rasterizer.back_at(col, t.rasterizer.framebuffer_row(row));
+}
+
+// Puts a line of text on every row, with the cursor left at the top left.
+static void fill(AnsiTerminal & a) {
+  a.write("\x1b[H0123456789abcdefghijABCDEFGHIJklmnopqrst\x1b[H");
+}
+
+static void test_addressing() {
+  static constexpr char const * test = "addressing";
+  Terminal t(width, height);
+  AnsiTerminal a(t);
+
+  a.write("\x1b[2;3Hx");
+  expect_cursor(t, 3, 1, test);
+  a.write("\x1b[Hy");
+  a.write("\x1b[99;99H");
+  expect_cursor(t, cols - 1, rows - 1, test);
+  a.write("\x1b[4;5H\x1b[2Az\x1b[B\x1b[3Dw");
+  a.write("\x1b[4;1H\x1b[9Ce\x1b[G\tt");
+  expect_rows(t, { "y         ",
+                   "  x z     ",
+                   "  w       ",
+                   "        te" }, test);
+  a.write("\r\x1b[2B");
+  expect_cursor(t, 0, rows - 1, test);
+}
+
+static void test_erase() {
+  static constexpr char const * test = "erase";
+  Terminal t(width, height);
+  AnsiTerminal a(t);
+
+  fill(a);
+  a.write("\x1b[1;5H\x1b[K");
+  a.write("\x1b[2;5H\x1b[1K");
+  a.write("\x1b[3;3H\x1b[4X");
+  a.write("\x1b[4;8H\x1b[2K");
+  expect_rows(t, { "0123      ",
+                   "     fghij",
+                   "AB    GHIJ",
+                   "          " }, test);
+
+  fill(a);
+  a.write("\x1b[2;4H\x1b[J");
+  expect_rows(t, { "0123456789",
+                   "abc       ",
+                   "          ",
+                   "          " }, test);
+
+  fill(a);
+  a.write("\x1b[3;4H\x1b[1J");
+  expect_rows(t, { "          ",
+                   "          ",
+                   "    EFGHIJ",
+                   "klmnopqrst" }, test);
+  expect_cursor(t, 3, 2, test);
+
+  a.write("\x1b[2J");
+  expect_rows(t, { "          ",
+                   "          ",
+                   "          ",
+                   "          " }, test);
+  expect_cursor(t, 3, 2, test);
+}
+
+static void test_scroll_region() {
+  static constexpr char const * test = "scroll region";
+  Terminal t(width, height);
+  AnsiTerminal a(t);
+
+  fill(a);
+  a.write("\x1b[2;3r");
+  expect_cursor(t, 0, 0, test);
+  a.write("\x1b[3;1H\nX");
+  expect_rows(t, { "0123456789",
+                   "ABCDEFGHIJ",
+                   "X         ",
+                   "klmnopqrst" }, test);
+
+  // A line feed below the region stops at the bottom, but doesn't scroll.
+  a.write("\x1b[4;1H\n\nY");
+  expect_rows(t, { "0123456789",
+                   "ABCDEFGHIJ",
+                   "X         ",
+                   "Ylmnopqrst" }, test);
+
+  // Reverse index at the top of the region scrolls it down.
+  a.write("\x1b[2;1H\x1bMZ");
+  expect_rows(t, { "0123456789",
+                   "Z         ",
+                   "ABCDEFGHIJ",
+                   "Ylmnopqrst" }, test);
+
+  a.write("\x1b[r\x1b[S");
+  expect_rows(t, { "Z         ",
+                   "ABCDEFGHIJ",
+                   "Ylmnopqrst",
+                   "          " }, test);
+}
+
+static void test_insert_delete_lines() {
+  static constexpr char const * test = "insert and delete lines";
+  Terminal t(width, height);
+  AnsiTerminal a(t);
+
+  fill(a);
+  a.write("\x1b[2;5H\x1b[L");
+  expect_rows(t, { "0123456789",
+                   "          ",
+                   "abcdefghij",
+                   "ABCDEFGHIJ" }, test);
+  expect_cursor(t, 0, 1, test);
+
+  a.write("\x1b[2M");
+  expect_rows(t, { "0123456789",
+                   "ABCDEFGHIJ",
+                   "          ",
+                   "          " }, test);
+
+  // Outside the scroll region, nothing moves.
+  fill(a);
+  a.write("\x1b[2;3r\x1b[4;1H\x1b[L\x1b[1;1H\x1b[M");
+  expect_rows(t, { "0123456789",
+                   "abcdefghij",
+                   "ABCDEFGHIJ",
+                   "klmnopqrst" }, test);
+
+  // Inside it, lines below it don't move.
+  a.write("\x1b[2;1H\x1b[L");
+  expect_rows(t, { "0123456789",
+                   "          ",
+                   "abcdefghij",
+                   "klmnopqrst" }, test);
+}
+
+static void test_colors() {
+  static constexpr char const * test = "colors";
+  Terminal t(width, height);
+  AnsiTerminal a(t, demo::lt_gray, demo::black);
+
+  a.write("a\x1b[31mb\x1b[1mc\x1b[22;42md\x1b[0me");
+  a.write("\x1b[38;5;196mf\x1b[38;5;255mg\x1b[48;2;0;0;255mh");
+  a.write("\x1b[0;7mi\x1b[1;34;27mj");
+
+  struct { Pixel fore, back; } const expected[] = {
+    { demo::lt_gray, demo::black },
+    { 0b000010, demo::black },     // Red.
+    { 0b000011, demo::black },     // Bold red is bright red.
+    { 0b000010, 0b001000 },        // Green background.
+    { demo::lt_gray, demo::black },
+    { 0b000011, demo::black },     // 256-color red.
+    { demo::white, demo::black },  // The top of the gray ramp.
+    { demo::white, 0b110000 },     // 24-bit blue.
+    { demo::black, demo::lt_gray },
+    { 0b110000, demo::black },     // Bold blue.
+  };
+  for (unsigned col = 0; col < cols; ++col) {
+    if (fore_at(t, col, 0) != expected[col].fore
+        || back_at(t, col, 0) != expected[col].back) {
+      std::printf("FAIL: %s: column %u is %02x on %02x, expected "
+                  "%02x on %02x\n",
+                  test, col, fore_at(t, col, 0), back_at(t, col, 0),
+                  expected[col].fore, expected[col].back);
+      ++failures;
+    }
+  }
+
+  // Erasing uses the current background.
+  a.write("\x1b[0;44m\x1b[2;1H\x1b[K");
+  expect(back_at(t, 5, 1) == 0b100000, test,
+         "erase should use the current background");
+}
+
+static void test_osc() {
+  static constexpr char const * test = "osc";
+  Terminal t(width, height);
+  AnsiTerminal a(t);
+
+  a.write("\x1b]0;title\x07" "ab");
+  a.write("\x1b]2;another title\x1b\\" "cd");
+  a.write("\x1b]8;;http://example.com/\x1b\\" "ef");
+  expect_rows(t, { "abcdef    ",
+                   "          ",
+                   "          ",
+                   "          " }, test);
+}
+
+static void test_split() {
+  static constexpr char const * test = "split";
+  Terminal t(width, height);
+  AnsiTerminal a(t);
+
+  fill(a);
+  a.write("\x1b", 1);
+  a.write("[", 1);
+  a.write("2;", 2);
+  a.write("3", 1);
+  a.write("Hx\x1b[3", 5);
+  a.write("1mK\x1b", 4);
+  a.write("]0;ti", 5);
+  a.write("tle\x07" "y", 5);
+  expect_rows(t, { "0123456789",
+                   "abxKyfghij",
+                   "ABCDEFGHIJ",
+                   "klmnopqrst" }, test);
+  expect(fore_at(t, 3, 1) == 0b000010 && fore_at(t, 2, 1) == demo::lt_gray,
+         test, "split SGR should color only what follows it");
+}
+
+/*
+ * Feeds the same random stream to two terminals, one in random chunks
+ * through write(char const *, unsigned), the other a byte at a time through
+ * write(char), and checks that they end up showing the same thing.
+ */
+static void test_fast_path() {
+  static constexpr char const * test = "fast path";
+  static char const * const pieces[] = {
+    "\r\n", "\n", "\r", "\b", "\t", "\x1b" "7", "\x1b" "8", "\x1b" "M",
+    "\x1b" "D", "\x1b" "E", "\x1b[K", "\x1b[1K", "\x1b[J", "\x1b[2J",
+    "\x1b[3X", "\x1b[L", "\x1b[2M", "\x1b[S", "\x1b[T", "\x1b[2;3r", "\x1b[r",
+    "\x1b[5;3H", "\x1b[2A", "\x1b[C", "\x1b[31m", "\x1b[1;44m", "\x1b[7m",
+    "\x1b[0m", "\x1b[38;5;200m", "\x1b[48;2;10;200;30m", "\x1b]0;title\x07",
+    "\x1b]2;t\x1b\\", "\x1b[?25l",
+  };
+  static constexpr unsigned piece_count = sizeof(pieces) / sizeof(*pieces);
+
+  std::mt19937 rng(1);
+  std::string stream;
+  while (stream.size() < 1000000) {
+    auto const kind = rng() % 8;
+    if (kind < 4) {
+      auto const n = rng() % 25;
+      for (unsigned i = 0; i < n; ++i) stream += char(0x20 + rng() % 0x5F);
+    } else if (kind < 7) {
+      stream += pieces[rng() % piece_count];
+    } else {
+      stream += char(rng() % 256);
+    }
+  }
+
+  Terminal fast_term(width, height), slow_term(width, height);
+  AnsiTerminal fast(fast_term), slow(slow_term);
+
+  for (std::size_t pos = 0; pos < stream.size();) {
+    auto n = unsigned(1 + rng() % 64);
+    if (n > stream.size() - pos) n = unsigned(stream.size() - pos);
+    fast.write(stream.data() + pos, n);
+    for (unsigned i = 0; i < n; ++i) slow.write(stream[pos + i]);
+    pos += n;
+
+    if (fast_term.t_col != slow_term.t_col
+        || fast_term.t_row != slow_term.t_row) {
+      std::printf("FAIL: %s: cursors differ at byte %zu\n", test, pos);
+      ++failures;
+      return;
+    }
+    for (unsigned row = 0; row < rows; ++row) {
+      for (unsigned col = 0; col < cols; ++col) {
+        auto const & f = fast_term.rasterizer, & s = slow_term.rasterizer;
+        if (f.char_at(col, f.framebuffer_row(row))
+              != s.char_at(col, s.framebuffer_row(row))
+            || fore_at(fast_term, col, row) != fore_at(slow_term, col, row)
+            || back_at(fast_term, col, row) != back_at(slow_term, col, row)) {
+          std::printf("FAIL: %s: cell %u,%u differs at byte %zu\n",
+                      test, col, row, pos);
+          ++failures;
+          return;
+        }
+      }
+    }
+  }
+}
+
+int main() {
+  test_addressing();
+  test_erase();
+  test_scroll_region();
+  test_insert_delete_lines();
+  test_colors();
+  test_osc();
+  test_split();
+  test_fast_path();
+
+  if (failures) {
+    std::printf("%u failures\n", failures);
+    return 1;
+  }
+  std::printf("All tests passed.\n");
+  return 0;
+}
@@ -0,0 +1,36 @@
+#include "demo/consoles.h"
+
+#include <new>
+
+#include "etl/assert.h"
+
+#include "vga/arena.h"
+
+namespace demo {
+
+Consoles::Consoles(unsigned count,
+                   unsigned width,
+                   unsigned height,
+                   unsigned top_line)
+  : band{nullptr, height, nullptr},
+    _count(count),
+    _terminals(vga::arena_new_array<Terminal *>(count)),
+    _shown(0) {
+  ETL_ASSERT(count != 0);
+  for (unsigned i = 0; i < count; ++i) {
+    _terminals[i] = new(vga::arena_alloc(sizeof(Terminal)))
+        Terminal{width, height, top_line};
+  }
+  band.rasterizer = &_terminals[0]->rasterizer;
+}
+
+void Consoles::show(unsigned i) {
+  ETL_ASSERT(i < _count);
+  _shown = i;
+}
+
+void Consoles::present() {
+  band.rasterizer = &_terminals[_shown]->rasterizer;
+}
+
+}  // namespace demo
@@ -0,0 +1,55 @@
+#ifndef DEMO_CONSOLES_H
+#define DEMO_CONSOLES_H
+
+#include "vga/vga.h"
+
+#include "demo/terminal.h"
+
+namespace demo {
+
+/*
+ * A set of Terminals sharing one band of the screen, only one of which is
+ * visible at a time -- virtual consoles.
+ *
+ * Each console has its own framebuffer in the arena, and can be written at
+ * any time, whether visible or not.  Switching consoles doesn't copy or
+ * redraw anything: it points the band at a different console's rasterizer.
+ * To avoid switching halfway down the screen, show() only records the
+ * choice, and present() makes it, and should be called during vblank.
+ *
+ * At 80x37 a console's framebuffer takes 11,840 bytes, so an otherwise empty
+ * arena has room for a dozen or so.
+ */
+class Consoles {
+public:
+  Consoles(unsigned count,
+           unsigned width,
+           unsigned height,
+           unsigned top_line = 0);
+
+  // The band to give to vga::configure_band_list.  Its 'next' may be set to
+  // chain further bands below it.
+  vga::Band band;
+
+  unsigned get_count() const { return _count; }
+
+  Terminal & operator[](unsigned i) { return *_terminals[i]; }
+
+  // The console chosen by the most recent call to show().
+  unsigned get_shown() const { return _shown; }
+
+  // Chooses the console to show from the next present() on.
+  void show(unsigned i);
+
+  // Points the band at the console chosen by show().  Call during vblank.
+  void present();
+
+private:
+  unsigned _count;
+  Terminal ** _terminals;
+  unsigned _shown;
+};
+
+}  // namespace demo
+
+#endif  // DEMO_CONSOLES_H
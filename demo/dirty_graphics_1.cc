@@ -0,0 +1,85 @@
+#include "demo/dirty_graphics_1.h"
+
+#include "etl/algorithm.h"
+#include "etl/assert.h"
+#include "etl/attribute_macros.h"
+
+#include "vga/arena.h"
+
+namespace demo {
+
+static vga::Graphics1 make_bitband_graphics(vga::rast::Bitmap_1 & r) {
+  if (!r.can_bg_use_bitband()) {
+    r.flip_now();
+    ETL_ASSERT(r.can_bg_use_bitband());
+  }
+  return r.make_bg_graphics();
+}
+
+DirtyGraphics1::DirtyGraphics1(vga::rast::Bitmap_1 & rasterizer,
+                               unsigned width,
+                               unsigned height)
+  : _rasterizer(rasterizer),
+    _g(make_bitband_graphics(rasterizer)),
+    _words_per_row(width / 32),
+    _height(height),
+    _dirty(vga::arena_new_array<std::uint32_t>((height + 31) / 32)) {
+  ETL_ASSERT(width % 32 == 0);
+  for (unsigned i = 0; i < (height + 31) / 32; ++i) _dirty[i] = 0;
+}
+
+void DirtyGraphics1::set_line_unclipped(int x0, int y0, int x1, int y1) {
+  _g.set_line_unclipped(x0, y0, x1, y1);
+  mark_rows(etl::min(y0, y1), etl::max(y0, y1) + 1);
+}
+
+void DirtyGraphics1::clear_all() {
+  _g.clear_all();
+  mark_rows(0, _height);
+}
+
+std::uint32_t * DirtyGraphics1::get_buffer() const {
+  return static_cast<std::uint32_t *>(_rasterizer.get_bg_buffer());
+}
+
+void DirtyGraphics1::mark_rows(unsigned top, unsigned bottom) {
+  bottom = etl::min(bottom, _height);
+  for (unsigned y = top; y < bottom; ++y) mark_row(y);
+}
+
+/*
+ * Runs of adjacent dirty rows are contiguous in both pages, so each is
+ * copied with a single word loop.
+ */
+ETL_SECTION(".ramcode")
+unsigned DirtyGraphics1::sync() {
+  auto const src = get_buffer();
+  auto const dst = static_cast<std::uint32_t *>(_rasterizer.get_fg_buffer());
+
+  unsigned copied_rows = 0;
+  unsigned y = 0;
+  while (y < _height) {
+    if (y % 32 == 0 && _dirty[y / 32] == 0) {
+      y += 32;
+      continue;
+    }
+    if ((_dirty[y / 32] & (1u << (y % 32))) == 0) {
+      ++y;
+      continue;
+    }
+
+    auto const top = y;
+    while (y < _height && (_dirty[y / 32] & (1u << (y % 32)))) ++y;
+
+    auto const begin = top * _words_per_row;
+    auto const end = y * _words_per_row;
+    for (unsigned w = begin; w < end; ++w) dst[w] = src[w];
+    copied_rows += y - top;
+  }
+
+  for (unsigned i = 0; i < (_height + 31) / 32; ++i) _dirty[i] = 0;
+
+  return (_height - copied_rows) * _words_per_row * sizeof(std::uint32_t);
+}
+
+}  // namespace demo
@@ -0,0 +1,75 @@
+#ifndef DEMO_DIRTY_GRAPHICS_1_H
+#define DEMO_DIRTY_GRAPHICS_1_H
+
+#include <cstdint>
+
+#include "vga/graphics_1.h"
+#include "vga/rast/bitmap_1.h"
+
+namespace demo {
+
+/*
+ * Draws into the background page of a Bitmap_1, like the Graphics1 it wraps,
+ * while keeping track of which rows have been touched.  sync() then brings
+ * the foreground page up to date by copying just those rows, where
+ * copy_bg_to_fg would copy the whole bitmap.
+ *
+ * This only works if everything drawn into the background goes through
+ * here, or is reported with mark_rows, and nothing else writes to the
+ * foreground.
+ */
+class DirtyGraphics1 {
+public:
+  // Flips the rasterizer's pages if need be, so that the background can use
+  // bit-banding, as Graphics1 requires.
+  DirtyGraphics1(vga::rast::Bitmap_1 &, unsigned width, unsigned height);
+
+  void set_pixel(unsigned x, unsigned y) {
+    _g.set_pixel(x, y);
+    mark_row(y);
+  }
+
+  void clear_pixel(unsigned x, unsigned y) {
+    _g.clear_pixel(x, y);
+    mark_row(y);
+  }
+
+  void set_line_unclipped(int x0, int y0, int x1, int y1);
+
+  void clear_all();
+
+  // The background page, for drawing into directly -- in which case, use
+  // mark_rows to say where.
+  std::uint32_t * get_buffer() const;
+
+  unsigned get_words_per_row() const { return _words_per_row; }
+
+  // Notes that rows top up to (not including) bottom have changed.
+  void mark_rows(unsigned top, unsigned bottom);
+
+  /*
+   * Copies the rows changed since the last sync from the background to the
+   * foreground, and forgets them.  Returns the number of bytes this saved
+   * over copying the whole bitmap.
+   */
+  unsigned sync();
+
+private:
+  vga::rast::Bitmap_1 & _rasterizer;
+  vga::Graphics1 _g;
+  unsigned _words_per_row;
+  unsigned _height;
+
+  // One bit per row, set when it has changed since the last sync.
+  std::uint32_t * _dirty;
+
+  // Rows outside the bitmap are ignored, so that drawing that strays off
+  // the edge doesn't corrupt the bookkeeping too.
+  void mark_row(unsigned y) {
+    if (y < _height) _dirty[y / 32] |= 1u << (y % 32);
+  }
+};
+
+}  // namespace demo
+
+#endif  // DEMO_DIRTY_GRAPHICS_1_H
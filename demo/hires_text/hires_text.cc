@@ -19,6 +19,8 @@ using Pixel = vga::Rasterizer::Pixel;
  */
 
 HiresText::HiresText() {
+  auto & t = _consoles[0];
+
   t.text_centered(0, white, dk_gray, "800x600 Attributed Text Demo");
   t.text_at(0, 1, white, black,
       "10x16 point characters in an 80x37 grid, with ");
@@ -79,14 +81,87 @@ HiresText::HiresText() {
 
   t.text_at(0, 36, white, black, "60 fps / 40MHz pixel clock");
   t.text_at(58, 36, white, black, "Frame number:");
+
+  draw_palette_page();
+  draw_status_page();
+  for (unsigned page = 0; page < page_count; ++page) {
+    draw_page_footer(page);
+  }
+}
+
+void HiresText::draw_page_footer(unsigned page) {
+  char footer[] = "Page 0 of 0 - center button for next";
+  footer[5] = '1' + page;
+  footer[10] = '0' + page_count;
+  _consoles[page].text_centered(35, dk_gray, black, footer);
+}
+
+void HiresText::draw_palette_page() {
+  auto & t = _consoles[1];
+
+  t.text_centered(0, white, dk_gray, "Palette");
+  t.text_centered(2, white, black,
+      "The 64 colors currently wired up, as BBGGRR in hex:");
+
+  // An 8x8 grid of swatches, each labeled with its color.  Light colors get
+  // dark labels.
+  for (unsigned color = 0; color < 64; ++color) {
+    auto const col = 8 + (color % 8) * 8;
+    auto const row = 5 + (color / 8) * 3;
+    auto const bright = (color & 0b11) + ((color >> 2) & 0b11)
+                      + ((color >> 4) & 0b11) > 4;
+    Pixel const fore = bright ? black : white;
+
+    char label[] = "  00  ";
+    label[2] = '0' + color / 16;
+    label[3] = "0123456789ABCDEF"[color % 16];
+    for (unsigned line = 0; line < 2; ++line) {
+      t.text_at(col, row + line, fore, color, line ? label : "      ");
+    }
+  }
+}
+
+void HiresText::draw_status_page() {
+  auto & t = _consoles[2];
+
+  t.text_centered(0, white, dk_gray, "Status");
+  t.text_at(4, 3, white, black, "Frame number:");
+  t.text_at(4, 4, white, black, "Uptime:");
+  t.text_at(4, 5, white, black, "Arena:");
+  t.text_at(4, 8, lt_gray, black,
+      "This page and the frame counter on page 1 are updated every frame,");
+  t.text_at(4, 9, lt_gray, black,
+      "whichever page is showing.  Flipping pages just repoints the band's");
+  t.text_at(4, 10, lt_gray, black,
+      "rasterizer during vblank; nothing is redrawn.");
+}
+
+// Formats n in decimal, right-aligned in a field of 'width' characters padded
+// with 'pad', into 'out', which must have room for width + 1.
+static void format_decimal(char *out, unsigned width, unsigned n,
+                           char pad = ' ') {
+  out[width] = 0;
+  for (unsigned i = width; i > 0; --i) {
+    out[i - 1] = (n || i == width) ? '0' + n % 10 : pad;
+    n /= 10;
+  }
 }
 
 void HiresText::configure_band_list() {
-  vga::configure_band_list(&band);
+  vga::configure_band_list(&_consoles.band);
 }
 
 bool HiresText::render_frame(unsigned frame) {
+  // We're called early in vblank, so this is the time to flip.
+  _consoles.present();
+
   bool continuing = !user_button_pressed();
+  if (center_button_pressed()) {
+    _consoles.show((_consoles.get_shown() + 1) % page_count);
+  }
+
+  auto const seconds = frame / config::notional_frame_rate;
+
   char fc[9];
   fc[8] = 0;
   // Write out frame number as hex.
@@ -95,7 +170,29 @@ bool HiresText::render_frame(unsigned frame) {
     fc[i - 1] = n > 9 ? 'A' + n - 10 : '0' + n;
     frame >>= 4;
   }
-  t.text_at(72, 36, red, black, fc);
+  _consoles[0].text_at(72, 36, red, black, fc);
+
+  auto & status = _consoles[2];
+  status.text_at(18, 3, red, black, fc);
+
+  char digits[11];
+  format_decimal(digits, 6, seconds / 3600);
+  status.text_at(18, 4, white, black, digits);
+  status.type(white, black, "h ");
+  format_decimal(digits, 2, seconds / 60 % 60, '0');
+  status.type(white, black, digits);
+  status.type(white, black, "m ");
+  format_decimal(digits, 2, seconds % 60, '0');
+  status.type(white, black, digits);
+  status.type(white, black, "s");
+
+  format_decimal(digits, 10, vga::arena_bytes_free());
+  status.text_at(18, 5, white, black, digits);
+  status.type(white, black, " of ");
+  format_decimal(digits, 10, vga::arena_bytes_total());
+  status.type(white, black, digits);
+  status.type(white, black, " bytes free");
+
   return continuing;
 }
 
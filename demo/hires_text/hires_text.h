@@ -3,8 +3,8 @@
 
 #include "vga/vga.h"
 
+#include "demo/consoles.h"
 #include "demo/scene.h"
-#include "demo/terminal.h"
 
 namespace demo {
 namespace hires_text {
@@ -13,12 +13,17 @@ namespace hires_text {
  * A Scene that shows some static attributed text including a frame counter.
  * The frame counter mostly just serves to show the frame rate, and dates back
  * to the days when text rendering was expensive.
+ *
+ * The text is on the first of several virtual consoles; the others show the
+ * palette and some live statistics.  The center button flips between them.
+ * Every console is updated each frame, visible or not.
  */
 class HiresText : public Scene {
 public:
   static constexpr unsigned
     cols = 800,
-    rows = 600;
+    rows = 600,
+    page_count = 3;
 
   HiresText();
 
@@ -26,8 +31,11 @@ public:
   bool render_frame(unsigned) override;
 
 private:
-  Terminal t{cols, rows};
-  vga::Band const band { &t.rasterizer, rows, nullptr };
+  Consoles _consoles{page_count, cols, rows};
+
+  void draw_page_footer(unsigned page);
+  void draw_palette_page();
+  void draw_status_page();
 };
 
 void legacy_run();
@@ -0,0 +1,185 @@
+#include "demo/line_1.h"
+
+#include <cstdlib>
+
+#include "etl/algorithm.h"
+#include "etl/attribute_macros.h"
+
+namespace demo {
+
+/*******************************************************************************
+ * Cohen-Sutherland clipping.
+ */
+
+enum Outcode : unsigned {
+  inside = 0,
+  left   = 1 << 0,
+  right  = 1 << 1,
+  above  = 1 << 2,
+  below  = 1 << 3,
+};
+
+static unsigned outcode(int x, int y, int x_max, int y_max) {
+  return (x < 0 ? left : x > x_max ? right : inside)
+       | (y < 0 ? above : y > y_max ? below : inside);
+}
+
+// Divides, rounding to nearest, so clipped endpoints stay on the line.
+static std::int64_t div_round(std::int64_t n, std::int64_t d) {
+  if (d < 0) {
+    n = -n;
+    d = -d;
+  }
+  return (n >= 0 ? n + d / 2 : n - d / 2) / d;
+}
+
+/*
+ * Clips the line to the rectangle from (0, 0) to (x_max, y_max), inclusive,
+ * moving the endpoints in place.  Returns false if no part of the line is
+ * inside.
+ *
+ * Intermediate products are computed in 64 bits, since the endpoints may be
+ * far off-screen (e.g. a vertex just in front of the eye).
+ */
+static bool clip(int & x0, int & y0, int & x1, int & y1,
+                 int x_max, int y_max) {
+  auto c0 = outcode(x0, y0, x_max, y_max);
+  auto c1 = outcode(x1, y1, x_max, y_max);
+
+  for (;;) {
+    if ((c0 | c1) == inside) return true;
+    if (c0 & c1) return false;  // Both ends off the same side.
+
+    // Move an outside endpoint to the edge it's outside of.
+    auto const c = c0 ? c0 : c1;
+    std::int64_t const dx = std::int64_t(x1) - x0,
+                       dy = std::int64_t(y1) - y0;
+    int x, y;
+    if (c & (above | below)) {
+      y = (c & above) ? 0 : y_max;
+      x = int(x0 + div_round(dx * (y - y0), dy));
+    } else {
+      x = (c & left) ? 0 : x_max;
+      y = int(y0 + div_round(dy * (x - x0), dx));
+    }
+
+    if (c == c0) {
+      x0 = x;
+      y0 = y;
+      c0 = outcode(x0, y0, x_max, y_max);
+    } else {
+      x1 = x;
+      y1 = y;
+      c1 = outcode(x1, y1, x_max, y_max);
+    }
+  }
+}
+
+
+/*******************************************************************************
+ * Run-slice Bresenham.
+ *
+ * A line that advances 'major' pixels along one axis and 'minor' along the
+ * other consists of minor + 1 runs of pixels along the major axis, whose
+ * lengths differ by at most one.  Rather than stepping pixel by pixel, we can
+ * compute each run's length with a Bresenham-style error term, and then draw
+ * the whole run at once.  This follows Abrash's formulation, which splits the
+ * leftover length evenly between the first and last runs for symmetry.
+ */
+
+template <typename Emit>
+static ETL_INLINE void slice_runs(unsigned major, unsigned minor, Emit emit) {
+  if (minor == 0) {
+    emit(major + 1);
+    return;
+  }
+
+  auto const whole_step = major / minor;
+  auto const adj_up = int(major % minor) * 2;
+  auto const adj_down = int(minor) * 2;
+  auto error = int(major % minor) - adj_down;
+
+  // Split the extra run between the ends of the line.  If the extra length
+  // is odd, the error term picks up the odd half pixel.
+  auto const final_run = whole_step / 2 + 1;
+  auto initial_run = final_run;
+  if (adj_up == 0 && (whole_step & 1) == 0) --initial_run;
+  if (whole_step & 1) error += int(minor);
+
+  emit(initial_run);
+  for (unsigned i = 0; i < minor - 1; ++i) {
+    auto run = whole_step;
+    if ((error += adj_up) > 0) {
+      ++run;
+      error -= adj_down;
+    }
+    emit(run);
+  }
+  emit(final_run);
+}
+
+// Sets pixels x_a through x_b, inclusive, within a single row.
+static ETL_INLINE void fill_span(std::uint32_t * row,
+                                 unsigned x_a, unsigned x_b) {
+  auto const w_a = x_a / 32, w_b = x_b / 32;
+  auto const mask_a = ~0u << (x_a % 32);
+  auto const mask_b = ~0u >> (31 - x_b % 32);
+
+  if (w_a == w_b) {
+    row[w_a] |= mask_a & mask_b;
+    return;
+  }
+
+  row[w_a] |= mask_a;
+  for (auto w = w_a + 1; w < w_b; ++w) row[w] = ~0u;
+  row[w_b] |= mask_b;
+}
+
+__attribute__((section(".ramcode.set_line")))
+void set_line(Bitmap1View const & view, int x0, int y0, int x1, int y1) {
+  if (!clip(x0, y0, x1, y1,
+            int(view.words_per_row * 32) - 1, int(view.height) - 1)) {
+    return;
+  }
+
+  // Always draw downward, so only X direction varies.
+  if (y0 > y1) {
+    auto const x = x0, y = y0;
+    x0 = x1;
+    y0 = y1;
+    x1 = x;
+    y1 = y;
+  }
+
+  auto const x_advance = x1 < x0 ? -1 : 1;
+  auto const dx = unsigned(std::abs(x1 - x0));
+  auto const dy = unsigned(y1 - y0);
+  auto const stride = view.words_per_row;
+
+  auto row = view.words + unsigned(y0) * stride;
+  auto x = x0;
+
+  if (dx >= dy) {
+    // X-major: one horizontal run per row, filled a word at a time.
+    slice_runs(dx, dy, [&](unsigned run) {
+      auto const end = x + x_advance * int(run - 1);
+      fill_span(row, unsigned(etl::min(x, end)), unsigned(etl::max(x, end)));
+      x = end + x_advance;
+      row += stride;
+    });
+  } else {
+    // Y-major: one vertical run per column.  There's no parallelism to be
+    // had here, but at least the bit and word are fixed over the run.
+    slice_runs(dy, dx, [&](unsigned run) {
+      auto const word = unsigned(x) / 32;
+      auto const bit = 1u << (unsigned(x) % 32);
+      for (unsigned i = 0; i < run; ++i) {
+        row[word] |= bit;
+        row += stride;
+      }
+      x += x_advance;
+    });
+  }
+}
+
+}  // namespace demo
@@ -0,0 +1,31 @@
+#ifndef DEMO_LINE_1_H
+#define DEMO_LINE_1_H
+
+#include <cstdint>
+
+namespace demo {
+
+/*
+ * A view of a 1bpp bitmap in the layout used by vga::rast::Bitmap_1: each
+ * row is a run of 32-bit words, with the leftmost pixel of each word in its
+ * least significant bit.
+ */
+struct Bitmap1View {
+  std::uint32_t * words;
+  unsigned words_per_row;
+  unsigned height;
+};
+
+/*
+ * Sets the pixels along the line from (x0, y0) to (x1, y1), inclusive.
+ *
+ * Unlike Graphics1::set_line_unclipped, the endpoints may lie anywhere: the
+ * line is clipped to the bitmap.  And rather than plotting one pixel at a
+ * time, this uses run-slice Bresenham to find each horizontal run of pixels
+ * and sets it a word at a time, which is much cheaper for shallow lines.
+ */
+void set_line(Bitmap1View const &, int x0, int y0, int x1, int y1);
+
+}  // namespace demo
+
+#endif  // DEMO_LINE_1_H
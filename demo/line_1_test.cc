@@ -0,0 +1,176 @@
+/*
+ * Host test and benchmark for set_line.
+ *
+ * Each line is drawn into a blank bitmap and compared with the ideal line
+ * between its endpoints.  For a line entirely on the bitmap, every pixel
+ * drawn must be within half a pixel of the ideal line along its minor axis,
+ * both endpoints must be drawn, and there must be exactly one pixel per step
+ * along the major axis.  For a line that needs clipping, the clipped
+ * endpoints are rounded to the nearest pixel, so drawn pixels may be up to a
+ * pixel and a half from the ideal line.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "demo/line_1.h"
+
+static constexpr unsigned
+  width = 800,
+  height = 400,
+  words_per_row = width / 32;
+
+struct Line {
+  int x0, y0, x1, y1;
+};
+
+static std::vector<std::uint32_t> bitmap(words_per_row * height);
+
+static bool pixel(unsigned x, unsigned y) {
+  return (bitmap[y * words_per_row + x / 32] >> (x % 32)) & 1;
+}
+
+static bool on_bitmap(int x, int y) {
+  return x >= 0 && x < int(width) && y >= 0 && y < int(height);
+}
+
+// Draws the line and checks it, printing a complaint and returning false if
+// it's wrong.
+static bool check(Line const & l) {
+  std::fill(bitmap.begin(), bitmap.end(), 0);
+  demo::set_line({bitmap.data(), words_per_row, height},
+                 l.x0, l.y0, l.x1, l.y1);
+
+  auto const unclipped = on_bitmap(l.x0, l.y0) && on_bitmap(l.x1, l.y1);
+  auto const tolerance = unclipped ? 0.5001 : 1.5;
+  auto const dx = double(l.x1) - l.x0, dy = double(l.y1) - l.y0;
+  auto const x_major = std::abs(dx) >= std::abs(dy);
+
+  unsigned count = 0;
+  for (unsigned y = 0; y < height; ++y) {
+    for (unsigned x = 0; x < width; ++x) {
+      if (!pixel(x, y)) continue;
+      ++count;
+
+      double error;
+      if (x_major) {
+        auto const ideal_y = dx ? l.y0 + dy * (int(x) - l.x0) / dx : l.y0;
+        error = std::fabs(ideal_y - y);
+      } else {
+        auto const ideal_x = l.x0 + dx * (int(y) - l.y0) / dy;
+        error = std::fabs(ideal_x - x);
+      }
+      if (error > tolerance) {
+        std::printf("FAIL: (%d, %d)-(%d, %d): pixel (%u, %u) is %g off\n",
+                    l.x0, l.y0, l.x1, l.y1, x, y, error);
+        return false;
+      }
+    }
+  }
+
+  if (unclipped) {
+    auto const expected = unsigned(std::max(std::abs(dx), std::abs(dy))) + 1;
+    if (count != expected) {
+      std::printf("FAIL: (%d, %d)-(%d, %d): %u pixels, expected %u\n",
+                  l.x0, l.y0, l.x1, l.y1, count, expected);
+      return false;
+    }
+    if (!pixel(l.x0, l.y0) || !pixel(l.x1, l.y1)) {
+      std::printf("FAIL: (%d, %d)-(%d, %d): endpoint missing\n",
+                  l.x0, l.y0, l.x1, l.y1);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks that a line missing the bitmap draws nothing.
+static bool check_invisible(Line const & l) {
+  std::fill(bitmap.begin(), bitmap.end(), 0);
+  demo::set_line({bitmap.data(), words_per_row, height},
+                 l.x0, l.y0, l.x1, l.y1);
+  for (auto w : bitmap) {
+    if (w) {
+      std::printf("FAIL: (%d, %d)-(%d, %d) should miss the bitmap\n",
+                  l.x0, l.y0, l.x1, l.y1);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  unsigned failures = 0;
+
+  // Clipping cases: lines crossing each edge and corner, lines far
+  // off-screen whose products overflow 32 bits, and lines that miss.
+  static Line const clipped[] {
+    { -50, 200, 850, 200 },
+    { 400, -50, 400, 450 },
+    { -100, -100, 900, 500 },
+    { 900, -100, -100, 500 },
+    { -1000000, 10, 1000000, 390 },
+    { 10, -1000000, 790, 1000000 },
+    { 400, 200, 2000000000, 1999999999 },
+    { -2000000000, 199, 400, 200 },
+    { 799, 0, 800, -1 },
+    { 0, 399, -1, 400 },
+  };
+  static Line const invisible[] {
+    { -10, -10, -1, -1 },
+    { 801, 0, 900, 399 },
+    { 0, 401, 799, 500 },
+    { -100, 50, 50, -100 },  // Passes the corner without touching it.
+    { -2000000000, -5, 2000000000, -5 },
+  };
+  for (auto const & l : clipped) failures += !check(l);
+  for (auto const & l : invisible) failures += !check_invisible(l);
+
+  // Random lines, a third entirely on the bitmap and the rest anywhere near
+  // it.
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> near_x(-300, 1100), near_y(-150, 550);
+  for (unsigned i = 0; i < 6000 && failures < 10; ++i) {
+    Line l;
+    if (i % 3 == 0) {
+      l = { int(rng() % width), int(rng() % height),
+            int(rng() % width), int(rng() % height) };
+    } else {
+      l = { near_x(rng), near_y(rng), near_x(rng), near_y(rng) };
+    }
+    failures += !check(l);
+  }
+
+  if (failures) {
+    std::printf("%u failures\n", failures);
+    return 1;
+  }
+  std::printf("All lines correct.\n");
+
+  // Benchmark: random lines on the bitmap.  This measures the host, but
+  // shows how the cost varies with the shape of the line.
+  std::vector<Line> lines(100000);
+  for (auto & l : lines) {
+    l = { int(rng() % width), int(rng() % height),
+          int(rng() % width), int(rng() % height) };
+  }
+  auto const start = std::chrono::steady_clock::now();
+  static constexpr unsigned rounds = 10;
+  for (unsigned r = 0; r < rounds; ++r) {
+    for (auto const & l : lines) {
+      demo::set_line({bitmap.data(), words_per_row, height},
+                     l.x0, l.y0, l.x1, l.y1);
+    }
+  }
+  auto const seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  std::printf("%.2f million lines per second\n",
+              rounds * lines.size() / seconds / 1e6);
+  return 0;
+}
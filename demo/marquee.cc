@@ -0,0 +1,33 @@
+#include "demo/marquee.h"
+
+namespace demo {
+
+Marquee::Marquee(vga::rast::Text_10x16 & text,
+                 unsigned row,
+                 unsigned const * message,
+                 unsigned length)
+  : _text(text),
+    _row(row),
+    _message(message),
+    _length(length),
+    _first(length) {}
+
+void Marquee::scroll_to(unsigned offset) {
+  offset %= _length * glyph_width;
+  _text.set_x_adj(-int(offset % glyph_width));
+
+  auto const first = offset / glyph_width;
+  if (first == _first) return;
+  _first = first;
+
+  // The rasterizer draws its framebuffer from the first column, and has no
+  // way to start elsewhere, so each glyph step rewrites the row -- but
+  // without clearing it first, since every cell gets replaced.
+  auto i = first;
+  for (unsigned col = 0; col < _text.get_col_count(); ++col) {
+    _text.put_packed(col, _row, _message[i]);
+    if (++i == _length) i = 0;
+  }
+}
+
+}  // namespace demo
@@ -0,0 +1,44 @@
+#ifndef DEMO_MARQUEE_H
+#define DEMO_MARQUEE_H
+
+#include "vga/rast/text_10x16.h"
+
+namespace demo {
+
+/*
+ * Scrolls a looping message leftward across one row of a text rasterizer.
+ *
+ * Motion within a glyph is done with the rasterizer's x adjustment, so the
+ * row's characters are only rewritten when the message has moved by a whole
+ * glyph -- every tenth pixel -- and are left alone in between.
+ *
+ * The message is given as packed characters, as taken by put_packed.  It's
+ * referenced, not copied, and should be at least as long as the row.
+ */
+class Marquee {
+public:
+  static constexpr unsigned glyph_width = 10;
+
+  Marquee(vga::rast::Text_10x16 &,
+          unsigned row,
+          unsigned const * message,
+          unsigned length);
+
+  // Shows the message scrolled left by 'offset' pixels.  The offset may
+  // exceed the message's width, and wraps around.
+  void scroll_to(unsigned offset);
+
+private:
+  vga::rast::Text_10x16 & _text;
+  unsigned _row;
+  unsigned const * _message;
+  unsigned _length;
+
+  // Index in the message of the character currently in the leftmost column,
+  // or _length if the row hasn't been written yet.
+  unsigned _first;
+};
+
+}  // namespace demo
+
+#endif  // DEMO_MARQUEE_H
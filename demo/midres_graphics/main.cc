@@ -1,15 +1,14 @@
-#include "etl/assert.h"
 #include "etl/scope_guard.h"
 
 #include "etl/armv7m/implicit_crt0.h"
 
 #include "vga/arena.h"
-#include "vga/graphics_1.h"
 #include "vga/rast/bitmap_1.h"
 #include "vga/timing.h"
 #include "vga/vga.h"
 
 #include "demo/config.h"
+#include "demo/dirty_graphics_1.h"
 
 DEMO_REQUIRE_RESOLUTION(640, 480)
 
@@ -20,15 +19,10 @@ struct Demo {
   Demo() {
     rasterizer.set_fg_color(0b111111);
     rasterizer.set_bg_color(0b100000);
-
-    if (!rasterizer.can_bg_use_bitband()) {
-      rasterizer.flip_now();
-      ETL_ASSERT(rasterizer.can_bg_use_bitband());
-    }
   }
 };
 
-static void set_ball(vga::Graphics1 &g, unsigned x, unsigned y) {
+static void set_ball(demo::DirtyGraphics1 &g, unsigned x, unsigned y) {
   g.set_pixel(x, y);
   g.set_pixel(x - 1, y);
   g.set_pixel(x + 1, y);
@@ -36,7 +30,7 @@ static void set_ball(vga::Graphics1 &g, unsigned x, unsigned y) {
   g.set_pixel(x, y + 1);
 }
 
-static void clear_ball(vga::Graphics1 &g, unsigned x, unsigned y) {
+static void clear_ball(demo::DirtyGraphics1 &g, unsigned x, unsigned y) {
   g.clear_pixel(x, y);
   g.clear_pixel(x - 1, y);
   g.clear_pixel(x + 1, y);
@@ -44,7 +38,7 @@ static void clear_ball(vga::Graphics1 &g, unsigned x, unsigned y) {
   g.clear_pixel(x, y + 1);
 }
 
-static void step_ball(vga::Graphics1 &g,
+static void step_ball(demo::DirtyGraphics1 &g,
                       int &x, int &y,
                       int other_x, int other_y,
                       int &xi, int &yi) {
@@ -83,7 +77,7 @@ int main() {
 
   auto d = vga::arena_make<Demo>();
 
-  vga::Graphics1 g = d->rasterizer.make_bg_graphics();
+  demo::DirtyGraphics1 g{d->rasterizer, 640, 480};
   g.clear_all();
 
   vga::configure_band_list(&d->band);
@@ -98,11 +92,11 @@ int main() {
 
   while (true) {
     step_ball(g, x[0], y[0], x[1], y[1], xi, yi);
-    d->rasterizer.copy_bg_to_fg();
+    g.sync();
     vga::sync_to_vblank();
 
     step_ball(g, x[1], y[1], x[0], y[0], xi, yi);
-    d->rasterizer.copy_bg_to_fg();
+    g.sync();
     vga::sync_to_vblank();
   }
   __builtin_unreachable();
@@ -0,0 +1,48 @@
+#include "demo/mock_text_10x16.h"
+
+namespace vga {
+
+// The mock draws nothing, so it needs no glyphs.
+unsigned char const font_10x16[1] {};
+
+namespace rast {
+
+Text_10x16::Text_10x16(unsigned char const *, unsigned,
+                       unsigned width, unsigned height,
+                       unsigned top_line, bool)
+  : cell_writes(0),
+    framebuffer_clears(0),
+    last_line(0),
+    _cols(width / 10),
+    _rows(height / 16),
+    _top_line(top_line),
+    _cells() {}
+
+auto Text_10x16::rasterize(unsigned, unsigned line_number, Pixel *)
+    -> RasterInfo {
+  last_line = line_number;
+  return { 0, 0, 0, 0 };
+}
+
+void Text_10x16::clear_framebuffer(Pixel bg) {
+  ++framebuffer_clears;
+  auto const blank = (unsigned(bg) << 16) | (unsigned(bg) << 8) | ' ';
+  for (auto & row : _cells) {
+    for (auto & cell : row) cell = blank;
+  }
+}
+
+void Text_10x16::put_char(unsigned col, unsigned row,
+                          Pixel fore, Pixel back, char c) {
+  put_packed(col, row, (unsigned(fore) << 16)
+                     | (unsigned(back) << 8)
+                     | static_cast<unsigned char>(c));
+}
+
+void Text_10x16::put_packed(unsigned col, unsigned row, unsigned p) {
+  ++cell_writes;
+  _cells[row][col] = p;
+}
+
+}  // namespace rast
+}  // namespace vga
@@ -0,0 +1,89 @@
+#ifndef DEMO_MOCK_TEXT_10X16_H
+#define DEMO_MOCK_TEXT_10X16_H
+
+#include <cstdint>
+
+/*
+ * Stand-ins for the parts of the vga library that Terminal uses, so that it
+ * and AnsiTerminal can be tested on the host, where the real ones can't run.
+ * terminal.h includes this instead of them when BUILDING_ON_HOST.
+ *
+ * Text_10x16 keeps each character cell in an array that tests can inspect,
+ * packed as put_packed takes it, and counts the writes made to it.  Its
+ * rasterize() draws nothing, but remembers the line it was asked for.
+ */
+
+namespace vga {
+
+class Rasterizer {
+public:
+  typedef std::uint8_t Pixel;
+
+  struct RasterInfo {
+    int offset;
+    unsigned length;
+    unsigned stretch_cycles;
+    unsigned repeat_lines;
+  };
+
+  virtual RasterInfo rasterize(unsigned cycles_per_pixel,
+                               unsigned line_number,
+                               Pixel *raster_target) = 0;
+
+protected:
+  ~Rasterizer() = default;
+};
+
+extern unsigned char const font_10x16[];
+
+namespace rast {
+
+class Text_10x16 : public Rasterizer {
+public:
+  static constexpr unsigned max_cols = 128, max_rows = 64;
+
+  Text_10x16(unsigned char const *font, unsigned glyph_count,
+             unsigned width, unsigned height,
+             unsigned top_line = 0, bool hide_right = false);
+
+  RasterInfo rasterize(unsigned, unsigned line_number, Pixel *) override;
+
+  void clear_framebuffer(Pixel bg);
+  void put_char(unsigned col, unsigned row, Pixel fore, Pixel back, char c);
+  void put_packed(unsigned col, unsigned row, unsigned p);
+
+  unsigned get_col_count() const { return _cols; }
+  unsigned get_row_count() const { return _rows; }
+
+  void set_top_line(unsigned line) { _top_line = line; }
+
+  /*
+   * For tests.
+   */
+
+  char char_at(unsigned col, unsigned row) const {
+    return char(_cells[row][col] & 0xFF);
+  }
+  Pixel fore_at(unsigned col, unsigned row) const {
+    return Pixel(_cells[row][col] >> 16);
+  }
+  Pixel back_at(unsigned col, unsigned row) const {
+    return Pixel(_cells[row][col] >> 8);
+  }
+
+  unsigned top_line() const { return _top_line; }
+
+  unsigned cell_writes;        // Calls to put_char and put_packed.
+  unsigned framebuffer_clears;
+  unsigned last_line;          // Line number last passed to rasterize.
+
+private:
+  unsigned _cols, _rows;
+  unsigned _top_line;
+  std::uint32_t _cells[max_rows][max_cols];
+};
+
+}  // namespace rast
+}  // namespace vga
+
+#endif  // DEMO_MOCK_TEXT_10X16_H
@@ -10,8 +10,6 @@ static constexpr unsigned
   disp_rows = 600,
   div_x = 2,
   div_y = 2,
-  map_width = 24,
-  map_height = 24,
   tex_width = 64,
   tex_height = 32,
   apparent_tex_height = tex_height * 2;
@@ -20,9 +18,26 @@ static constexpr int
   cols = int(disp_cols) / div_x,
   rows = int(disp_rows) / div_y;
 
+// When set, each frame of a still or nearly-still view casts only half of the
+// columns -- alternating between even and odd columns -- and carries the rest
+// over from the previous frame, roughly halving its cost.  Frames where the
+// camera moves cast every column, as without interleaving.
+static constexpr bool interleave = true;
+
 static constexpr float
   pi = 3.14159265358f,
-  fov = 0.66f;
+  fov = 0.66f,
+  // Sprites closer to the camera plane than this are not drawn.
+  sprite_min_depth = 0.1f,
+  // Distance (in tiles) covered by each distance shading level.  Beyond
+  // tex_shade_count of these, everything is drawn at the darkest level.
+  shade_distance = 3.f,
+  // Above this turn rate (radians per frame) or speed (tiles per frame),
+  // interleaving smears, so we fall back to casting every column.  A single
+  // turn step is 0.01 radians and a walk step 0.1 tiles, so any input from
+  // the controls counts.
+  max_interleave_turn = 0.005f,
+  max_interleave_travel = 0.02f;
 
 }  // namespace config
 }  // namespace raycast
@@ -0,0 +1,16 @@
+#include "demo/raycast/raycast.h"
+#include "demo/raycast/large.h"
+
+#include "demo/runner.h"
+
+/*
+ * The ray caster on the 256x256 map from large.map, for comparing frame
+ * times against the default 24x24 level.
+ */
+struct LargeRayCast : demo::raycast::RayCast {
+  LargeRayCast() : RayCast(demo::raycast::large_map) {}
+};
+
+int main() {
+  demo::run<LargeRayCast>();
+}
@@ -0,0 +1,80 @@
+#!/usr/bin/env ruby
+
+# Generates large.map: a 256x256 map for exercising the ray caster's
+# empty-space skipping, where most rays cross a lot of open floor before they
+# hit anything.
+#
+# The default level sits in the northwest corner, with doorways knocked
+# through its east and south walls, so the camera's usual starting point and
+# the canned sprites still make sense.  The rest is open ground scattered
+# with square pillars and a few long walls.
+#
+# Usage: make_large_map.rb level.map > large.map
+
+SIZE = 256
+
+level = File.readlines(ARGV[0]).map(&:strip).reject { |line|
+  line.empty? or line.start_with?('#')
+}
+
+map = Array.new(SIZE) { Array.new(SIZE, '0') }
+
+# A fixed LCG, so that the output only changes when this script does.
+$seed = 1118
+def rand_below(n)
+  $seed = ($seed * 1103515245 + 12345) & 0x7FFFFFFF
+  ($seed >> 8) % n
+end
+
+def texture
+  (1 + rand_below(5)).to_s
+end
+
+(0...SIZE).each { |i|
+  map[0][i] = map[SIZE - 1][i] = map[i][0] = map[i][SIZE - 1] = texture
+}
+
+# Long walls, at least a few cells clear of each other and of the border.
+12.times {
+  len = 16 + rand_below(48)
+  x = 4 + rand_below(SIZE - 8 - len)
+  y = 32 + rand_below(SIZE - 36)
+  t = texture
+  if rand_below(2) == 0
+    (x...x + len).each { |i| map[y][i] = t }
+  else
+    (x...x + len).each { |i| map[i][y] = t }
+  end
+}
+
+# Pillars.
+400.times {
+  x = 2 + rand_below(SIZE - 6)
+  y = 2 + rand_below(SIZE - 6)
+  size = 1 + rand_below(3)
+  t = texture
+  (y...y + size).each { |j| (x...x + size).each { |i| map[j][i] = t } }
+}
+
+# Clear the ground just outside the level so its doorways lead somewhere,
+# then drop it in.
+(0...level.size + 4).each { |y|
+  (0...level.first.size + 4).each { |x| map[y][x] = '0' }
+}
+level.each_with_index { |row, y|
+  row.each_char.with_index { |c, x| map[y][x] = c }
+}
+map[0][0, level.first.size + 4] = Array.new(level.first.size + 4, '1')
+(0...level.size + 4).each { |y| map[y][0] = '1' }
+
+last_x = level.first.size - 1
+last_y = level.size - 1
+(9..11).each { |i|
+  map[i][last_x] = '0'
+  map[last_y][i] = '0'
+}
+
+puts '# Large raycast level, generated by make_large_map.rb -- do not edit.'
+puts '#'
+puts '# One map row per line, one hex digit per cell, as in level.map.'
+map.each { |row| puts row.join }
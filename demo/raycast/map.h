@@ -4,19 +4,45 @@
 #include <cstdint>
 
 #include "demo/raycast/config.h"
+#include "demo/raycast/sprite.h"
 
 namespace demo {
 namespace raycast {
 
+/*
+ * A map is a closed grid of cells, generated from a text file by
+ * process_map.rb.  Each cell is packed into a single byte:
+ *
+ * - The low nibble holds the wall's texture number plus one, or zero for open
+ *   space.
+ *
+ * - The high nibble holds the cell's "clearance": the Chebyshev distance to
+ *   the nearest wall cell, saturating at 15.  Every cell within clearance - 1
+ *   steps of an open cell, along both axes, is also open, which lets the ray
+ *   caster skip across empty space without visiting each tile.
+ *
+ * At one byte per cell, a 256x256 map costs 64KiB of Flash.
+ */
 struct Map {
-  std::uint8_t tiles[config::map_width * config::map_height];
+  static constexpr unsigned
+    tile_mask = 0xF,
+    clearance_shift = 4;
+
+  unsigned width;
+  unsigned height;
+  std::uint8_t const * cells;
+
+  inline std::uint8_t cell(unsigned x, unsigned y) const {
+    return cells[y * width + x];
+  }
 
   inline std::uint8_t fetch(unsigned x, unsigned y) const {
-    return tiles[y * config::map_width + x];
+    return cell(x, y) & tile_mask;
   }
 };
 
-extern Map const canned_map;
+static constexpr unsigned canned_sprite_count = 4;
+extern Sprite const canned_sprites[canned_sprite_count];
 
 }  // namespace raycast
 }  // namespace demo
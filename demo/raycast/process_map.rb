@@ -0,0 +1,127 @@
+#!/usr/bin/env ruby
+
+IN = ARGV[0]
+OUTDIR = ARGV[1]
+NAME = ARGV[2]
+
+# Cells are packed into one byte: texture number (plus one) in the low nibble,
+# clearance in the high nibble.  These must agree with demo/raycast/map.h.
+MAX_TILE = 15
+MAX_CLEARANCE = 15
+
+STDERR.puts "Loading #{IN}..."
+
+rows = File.readlines(IN).map(&:strip).reject { |line|
+  line.empty? or line.start_with?('#')
+}
+
+height = rows.size
+width = rows.first.size
+
+if rows.any? { |r| r.size != width }
+  raise "Map rows must all be #{width} cells wide"
+end
+
+tiles = rows.map { |r|
+  r.each_char.map { |c|
+    t = c.to_i(16)
+    if c !~ /\h/ or t > MAX_TILE
+      raise "Bad map cell #{c.inspect}"
+    end
+    t
+  }
+}
+
+(0...width).each { |x|
+  if tiles[0][x] == 0 or tiles[height - 1][x] == 0
+    raise "Map is not closed at column #{x}"
+  end
+}
+(0...height).each { |y|
+  if tiles[y][0] == 0 or tiles[y][width - 1] == 0
+    raise "Map is not closed at row #{y}"
+  end
+}
+
+STDERR.puts "Map size: #{width}x#{height}"
+
+# Chebyshev (chessboard) distance from each cell to the nearest wall, computed
+# with the classic two-pass chamfer transform.  With unit weights on all eight
+# neighbors this is exact.
+dist = tiles.map { |r| r.map { |t| t == 0 ? MAX_CLEARANCE : 0 } }
+
+def relax(dist, x, y, width, height, nbrs)
+  nbrs.each { |dx, dy|
+    nx = x + dx
+    ny = y + dy
+    next if nx < 0 or ny < 0 or nx >= width or ny >= height
+    d = dist[ny][nx] + 1
+    dist[y][x] = d if d < dist[y][x]
+  }
+end
+
+FORWARD = [[-1, 0], [-1, -1], [0, -1], [1, -1]]
+BACKWARD = [[1, 0], [1, 1], [0, 1], [-1, 1]]
+
+(0...height).each { |y|
+  (0...width).each { |x| relax(dist, x, y, width, height, FORWARD) }
+}
+(height - 1).downto(0) { |y|
+  (width - 1).downto(0) { |x| relax(dist, x, y, width, height, BACKWARD) }
+}
+
+cells = (0...height).flat_map { |y|
+  (0...width).map { |x| tiles[y][x] | (dist[y][x] << 4) }
+}
+
+open_cells = cells.count { |c| (c & 0xF) == 0 }
+mean = open_cells == 0 ? 0 :
+  cells.select { |c| (c & 0xF) == 0 }.map { |c| c >> 4 }.sum.to_f / open_cells
+STDERR.puts "#{open_cells} open cells, mean clearance #{mean.round(2)}."
+
+STDERR.puts "Output going into #{OUTDIR}."
+
+File.open("#{OUTDIR}/#{NAME}.h", 'w') { |f|
+  f.puts <<-END.gsub(/^ {4}/, '')
+    #ifndef DEMO_RAYCAST_#{NAME.upcase}_H
+    #define DEMO_RAYCAST_#{NAME.upcase}_H
+
+    #include "demo/raycast/map.h"
+
+    namespace demo {
+    namespace raycast {
+
+    extern Map const #{NAME}_map;
+
+    }  // namespace raycast
+    }  // namespace demo
+
+    #endif  // DEMO_RAYCAST_#{NAME.upcase}_H
+  END
+}
+
+File.open("#{OUTDIR}/#{NAME}.cc", 'w') { |f|
+  f.puts <<-END.gsub(/^ {4}/, '')
+    #include "demo/raycast/#{NAME}.h"
+
+    namespace demo {
+    namespace raycast {
+
+  END
+
+  f.puts "static std::uint8_t const #{NAME}_cells[#{width * height}] {"
+  cells.each_slice(width) { |row|
+    row.each_slice(16) { |chunk|
+      f.puts "  " + chunk.map { |c| "0x%02x," % c }.join(' ')
+    }
+  }
+  f.puts "};"
+  f.puts
+  f.puts "Map const #{NAME}_map { #{width}, #{height}, #{NAME}_cells };"
+
+  f.puts <<-END.gsub(/^ {4}/, '')
+
+    }  // namespace raycast
+    }  // namespace demo
+  END
+}
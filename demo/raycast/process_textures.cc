@@ -0,0 +1,732 @@
+/*
+ * Host tool that converts a sheet of raycaster textures into C++ source.
+ *
+ * Usage: process_textures <input.pnm> <output-dir> <name> [--4bpp]
+ *
+ * The input is a PNM image (ASCII P3 or binary P6) holding textures side by
+ * side.  The output is <name>.h and <name>.cc in the output directory; see
+ * demo/raycast/texture.h for the layout.
+ *
+ * The palette holds 256 entries, each a pair of top/bottom colors for the
+ * mirrored display.  Entry 0 is the ceiling/floor.  The remaining entries
+ * are shared between the texture colors and their distance-shaded variants.
+ * When the textures use more color pairs than fit, they are reduced by
+ * median cut followed by a few rounds of k-means, shrinking the target until
+ * both the texture colors and their shades fit.
+ *
+ * With --4bpp, each texture is further reduced to (at most) 16 of the global
+ * palette entries and stored as packed 4-bit indices into a per-texture
+ * sub-palette.
+ *
+ * This is built and run on the host by site_cobble/compile_raycast_texture.py.
+ */
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static constexpr unsigned
+  tex_width = 64,
+  tex_height = 64,
+  // Number of mip levels, including the full-size one.  Must agree with
+  // demo/raycast/texture.h.
+  mip_levels = 4,
+  // Number of distance shading levels, including the unshaded one.  Each
+  // level after the first fades colors further toward black.
+  shade_levels = 4,
+  palette_size = 256,
+  // Rounds of k-means refinement applied after median cut.
+  kmeans_rounds = 8;
+
+/*
+ * Colors are 6 bits: two bits each of red, green, and blue, in that order
+ * from the LSB.  A color pair puts the top color in bits 11:6 and the bottom
+ * color in bits 5:0, which conveniently makes it six two-bit channels.
+ */
+static constexpr unsigned pair_count = 1 << 12, pair_channels = 6;
+
+[[noreturn]] static void fail(char const * fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  std::vfprintf(stderr, fmt, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+  std::exit(1);
+}
+
+static unsigned make_pair(unsigned top, unsigned bot) {
+  return (top << 6) | bot;
+}
+
+static unsigned pair_top(unsigned pair) { return pair >> 6; }
+static unsigned pair_bot(unsigned pair) { return pair & 0x3F; }
+
+static unsigned channel(unsigned pair, unsigned c) {
+  return (pair >> (2 * c)) & 3;
+}
+
+static unsigned distance(unsigned a, unsigned b) {
+  unsigned d = 0;
+  for (unsigned c = 0; c < pair_channels; ++c) {
+    int delta = int(channel(a, c)) - int(channel(b, c));
+    d += unsigned(delta * delta);
+  }
+  return d;
+}
+
+/*
+ * Scales each channel of a color pair for a shade level, rounding to
+ * nearest.
+ */
+static unsigned shade(unsigned pair, unsigned level) {
+  unsigned result = 0;
+  for (unsigned c = 0; c < pair_channels; ++c) {
+    unsigned x = channel(pair, c);
+    unsigned scaled = (2 * x * (shade_levels - level) + shade_levels)
+                    / (2 * shade_levels);
+    result |= scaled << (2 * c);
+  }
+  return result;
+}
+
+
+/*******************************************************************************
+ * Input
+ */
+
+struct Rgb {
+  unsigned r, g, b;
+};
+
+struct Image {
+  unsigned width, height;
+  std::vector<Rgb> samples;
+
+  Rgb const & at(unsigned x, unsigned y) const {
+    return samples[y * width + x];
+  }
+};
+
+static std::vector<unsigned char> read_file(char const * path) {
+  auto f = std::fopen(path, "rb");
+  if (!f) fail("can't open %s", path);
+
+  std::vector<unsigned char> data;
+  unsigned char buf[65536];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  std::fclose(f);
+  return data;
+}
+
+/*
+ * Minimal PNM reader.  Supports ASCII (P3) and binary (P6) pixmaps with any
+ * maximum value, scaling samples to 8 bits.
+ */
+class PnmReader {
+public:
+  explicit PnmReader(std::vector<unsigned char> const & data)
+    : _data(data), _pos(0) {}
+
+  Image read() {
+    skip_space();
+    if (_pos + 2 > _data.size() || _data[_pos] != 'P') fail("not a PNM file");
+    char kind = char(_data[_pos + 1]);
+    _pos += 2;
+    if (kind != '3' && kind != '6') {
+      fail("bad PNM format P%c (expected P3 or P6)", kind);
+    }
+
+    Image image;
+    image.width = number();
+    image.height = number();
+    unsigned maxval = number();
+    if (maxval == 0 || maxval > 65535) fail("bad maximum value %u", maxval);
+
+    auto const count = size_t(image.width) * image.height * 3;
+    std::vector<unsigned> raw(count);
+
+    if (kind == '3') {
+      for (auto & v : raw) v = number();
+    } else {
+      // Exactly one whitespace character separates the header from data.
+      ++_pos;
+      unsigned const bytes = maxval < 256 ? 1 : 2;
+      if (_data.size() - std::min(_pos, _data.size()) < count * bytes) {
+        fail("truncated PNM data");
+      }
+      for (auto & v : raw) {
+        v = bytes == 1 ? _data[_pos]
+                       : unsigned(_data[_pos] << 8) | _data[_pos + 1];
+        _pos += bytes;
+      }
+    }
+
+    skip_space();
+    if (_pos < _data.size()) fail("garbage at end of input");
+
+    image.samples.resize(size_t(image.width) * image.height);
+    for (size_t i = 0; i < image.samples.size(); ++i) {
+      auto scale = [maxval](unsigned v) {
+        if (v > maxval) fail("sample %u out of range", v);
+        return (v * 255 + maxval / 2) / maxval;
+      };
+      image.samples[i] = {
+        scale(raw[3 * i]), scale(raw[3 * i + 1]), scale(raw[3 * i + 2]),
+      };
+    }
+    return image;
+  }
+
+private:
+  std::vector<unsigned char> const & _data;
+  size_t _pos;
+
+  void skip_space() {
+    while (_pos < _data.size()) {
+      if (_data[_pos] == '#') {
+        while (_pos < _data.size() && _data[_pos] != '\n') ++_pos;
+      } else if (std::strchr(" \t\r\n\v\f", _data[_pos])) {
+        ++_pos;
+      } else {
+        break;
+      }
+    }
+  }
+
+  unsigned number() {
+    skip_space();
+    if (_pos >= _data.size() || _data[_pos] < '0' || _data[_pos] > '9') {
+      fail("expected number at offset %zu", _pos);
+    }
+    unsigned n = 0;
+    while (_pos < _data.size() && _data[_pos] >= '0' && _data[_pos] <= '9') {
+      n = n * 10 + unsigned(_data[_pos++] - '0');
+    }
+    return n;
+  }
+};
+
+
+/*******************************************************************************
+ * Mip generation
+ */
+
+typedef std::vector<Rgb> Grid;  // Square, row-major.
+
+static unsigned to_color(Rgb const & s) {
+  return (s.r >> 6) | ((s.g >> 6) << 2) | ((s.b >> 6) << 4);
+}
+
+// Box-filters a square grid of samples down by half in each dimension.
+static Grid downsample(Grid const & grid, unsigned size) {
+  auto const half = size / 2;
+  Grid out(half * half);
+  for (unsigned y = 0; y < half; ++y) {
+    for (unsigned x = 0; x < half; ++x) {
+      Rgb const * quad[] = {
+        &grid[2*y * size + 2*x],     &grid[2*y * size + 2*x + 1],
+        &grid[(2*y + 1) * size + 2*x], &grid[(2*y + 1) * size + 2*x + 1],
+      };
+      Rgb sum {2, 2, 2};  // Round to nearest.
+      for (auto s : quad) {
+        sum.r += s->r;
+        sum.g += s->g;
+        sum.b += s->b;
+      }
+      out[y * half + x] = { sum.r / 4, sum.g / 4, sum.b / 4 };
+    }
+  }
+  return out;
+}
+
+/*
+ * Converts a texture (with all its mip levels) into color pairs, in the
+ * column-major, top-half-only order used by the raycaster.
+ */
+static std::vector<unsigned> texture_pairs(Image const & image,
+                                           unsigned texnum) {
+  Grid grid(tex_width * tex_height);
+  for (unsigned y = 0; y < tex_height; ++y) {
+    for (unsigned x = 0; x < tex_width; ++x) {
+      grid[y * tex_width + x] = image.at(x + texnum * tex_width, y);
+    }
+  }
+
+  std::vector<unsigned> pairs;
+  for (unsigned level = 0; level < mip_levels; ++level) {
+    auto const size = tex_width >> level;
+    for (unsigned x = 0; x < size; ++x) {
+      for (unsigned y = 0; y < size / 2; ++y) {
+        auto const y_ = size - 1 - y;
+        pairs.push_back(make_pair(to_color(grid[y * size + x]),
+                                  to_color(grid[y_ * size + x])));
+      }
+    }
+    grid = downsample(grid, size);
+  }
+  return pairs;
+}
+
+
+/*******************************************************************************
+ * Quantization
+ */
+
+struct Entry {
+  unsigned pair;
+  unsigned long count;
+};
+
+// Weighted mean of a set of entries, rounded to the nearest color pair.
+template <typename Iter>
+static unsigned mean_pair(Iter begin, Iter end) {
+  unsigned long sums[pair_channels] = {};
+  unsigned long total = 0;
+  for (auto it = begin; it != end; ++it) {
+    for (unsigned c = 0; c < pair_channels; ++c) {
+      sums[c] += channel(it->pair, c) * it->count;
+    }
+    total += it->count;
+  }
+
+  unsigned pair = 0;
+  for (unsigned c = 0; c < pair_channels; ++c) {
+    pair |= unsigned((sums[c] + total / 2) / total) << (2 * c);
+  }
+  return pair;
+}
+
+/*
+ * Chooses (at most) k color pairs to represent the weighted set 'entries'.
+ * If there are no more than k distinct entries, they are returned unchanged.
+ */
+static std::vector<unsigned> quantize(std::vector<Entry> entries, unsigned k) {
+  struct Box { size_t begin, end; };
+  std::vector<Box> boxes { {0, entries.size()} };
+
+  // Median cut: repeatedly split the box with the widest channel at the
+  // weighted median along that channel.
+  while (boxes.size() < k) {
+    size_t best = boxes.size();
+    unsigned best_range = 0, best_channel = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+      for (unsigned c = 0; c < pair_channels; ++c) {
+        unsigned lo = 3, hi = 0;
+        for (size_t e = boxes[i].begin; e < boxes[i].end; ++e) {
+          lo = std::min(lo, channel(entries[e].pair, c));
+          hi = std::max(hi, channel(entries[e].pair, c));
+        }
+        if (hi > lo && hi - lo > best_range) {
+          best = i;
+          best_range = hi - lo;
+          best_channel = c;
+        }
+      }
+    }
+    if (best == boxes.size()) break;  // Every box holds a single pair.
+
+    auto const box = boxes[best];
+    auto const c = best_channel;
+    std::sort(entries.begin() + box.begin, entries.begin() + box.end,
+              [c](Entry const & a, Entry const & b) {
+                return channel(a.pair, c) != channel(b.pair, c)
+                    ? channel(a.pair, c) < channel(b.pair, c)
+                    : a.pair < b.pair;
+              });
+
+    unsigned long total = 0;
+    for (size_t e = box.begin; e < box.end; ++e) total += entries[e].count;
+
+    size_t split = box.begin + 1;
+    for (unsigned long acc = entries[box.begin].count;
+         split < box.end - 1 && acc * 2 < total;
+         ++split) {
+      acc += entries[split].count;
+    }
+
+    boxes[best] = { box.begin, split };
+    boxes.push_back({ split, box.end });
+  }
+
+  std::vector<unsigned> reps;
+  for (auto const & box : boxes) {
+    reps.push_back(mean_pair(entries.begin() + box.begin,
+                             entries.begin() + box.end));
+  }
+
+  // K-means: move each representative to the mean of the entries nearest
+  // it, until things settle.
+  for (unsigned round = 0; round < kmeans_rounds; ++round) {
+    std::vector<std::vector<Entry>> clusters(reps.size());
+    for (auto const & e : entries) {
+      size_t nearest = 0;
+      for (size_t r = 1; r < reps.size(); ++r) {
+        if (distance(e.pair, reps[r]) < distance(e.pair, reps[nearest])) {
+          nearest = r;
+        }
+      }
+      clusters[nearest].push_back(e);
+    }
+
+    bool changed = false;
+    for (size_t r = 0; r < reps.size(); ++r) {
+      if (clusters[r].empty()) continue;
+      auto const mean = mean_pair(clusters[r].begin(), clusters[r].end());
+      changed |= mean != reps[r];
+      reps[r] = mean;
+    }
+    if (!changed) break;
+  }
+
+  std::sort(reps.begin(), reps.end());
+  reps.erase(std::unique(reps.begin(), reps.end()), reps.end());
+  return reps;
+}
+
+struct Palette {
+  std::vector<unsigned> pairs;
+  std::vector<int> index_of;
+
+  // Entry 0 is reserved for the ceiling/floor, and is never matched.
+  Palette() : pairs{0}, index_of(pair_count, -1) {}
+
+  unsigned alloc(unsigned pair) {
+    if (index_of[pair] < 0) {
+      index_of[pair] = int(pairs.size());
+      pairs.push_back(pair);
+    }
+    return unsigned(index_of[pair]);
+  }
+
+  // Finds the closest entry among the first 'limit', skipping entry 0.
+  unsigned nearest(unsigned pair, size_t limit) const {
+    unsigned best = 1;
+    for (unsigned pi = 2; pi < limit; ++pi) {
+      if (distance(pairs[pi], pair) < distance(pairs[best], pair)) best = pi;
+    }
+    return best;
+  }
+};
+
+/*
+ * Builds a palette from (at most) k texture colors chosen to represent
+ * 'entries', followed by their shaded variants, and the shade remapping
+ * tables.  Returns true if the result fits in the hardware palette.
+ */
+static bool build_palette(std::vector<Entry> const & entries, unsigned k,
+                          Palette & palette,
+                          std::vector<std::vector<unsigned>> & shades) {
+  palette = Palette();
+  for (auto pair : quantize(entries, k)) palette.alloc(pair);
+
+  auto const base_colors = palette.pairs.size();
+  shades.assign(1, std::vector<unsigned>(base_colors));
+  for (unsigned pi = 0; pi < base_colors; ++pi) shades[0][pi] = pi;
+  for (unsigned level = 1; level < shade_levels; ++level) {
+    shades.emplace_back(base_colors);
+    // Ceiling/floor is not shaded.
+    for (unsigned pi = 1; pi < base_colors; ++pi) {
+      shades[level][pi] = palette.alloc(shade(palette.pairs[pi], level));
+    }
+  }
+
+  return palette.pairs.size() <= palette_size;
+}
+
+/*
+ * Reduces a texture's palette indices to 16, replacing rarely-used colors
+ * with their nearest frequently-used neighbor.  Fills in the sub-palette and
+ * rewrites the indices relative to it.  Returns the number of texels
+ * approximated.
+ */
+static unsigned quantize16(Palette const & palette,
+                           std::vector<unsigned> & indices,
+                           std::vector<unsigned> & sub_palette) {
+  std::vector<unsigned long> counts(palette.pairs.size());
+  for (auto pi : indices) ++counts[pi];
+
+  std::vector<unsigned> keep;
+  for (unsigned pi = 0; pi < counts.size(); ++pi) {
+    if (counts[pi]) keep.push_back(pi);
+  }
+  std::stable_sort(keep.begin(), keep.end(), [&](unsigned a, unsigned b) {
+    return counts[a] > counts[b];
+  });
+  if (keep.size() > 16) keep.resize(16);
+
+  std::vector<unsigned> remap(palette.pairs.size());
+  for (unsigned pi = 0; pi < counts.size(); ++pi) {
+    if (!counts[pi]) continue;
+    unsigned best = 0;
+    for (unsigned k = 1; k < keep.size(); ++k) {
+      if (distance(palette.pairs[keep[k]], palette.pairs[pi])
+          < distance(palette.pairs[keep[best]], palette.pairs[pi])) {
+        best = k;
+      }
+    }
+    remap[pi] = best;
+  }
+
+  unsigned approximated = 0;
+  for (auto & pi : indices) {
+    if (palette.pairs[keep[remap[pi]]] != palette.pairs[pi]) ++approximated;
+    pi = remap[pi];
+  }
+
+  sub_palette = keep;
+  sub_palette.resize(16, 0);
+  return approximated;
+}
+
+
+/*******************************************************************************
+ * Output
+ */
+
+static void write_header(std::string const & path, std::string const & name,
+                         unsigned color_count, unsigned texture_count,
+                         unsigned base_colors) {
+  auto f = std::fopen(path.c_str(), "w");
+  if (!f) fail("can't create %s", path.c_str());
+
+  std::string guard = "DEMO_RAYCAST_" + name + "_H";
+  std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+  auto const n = name.c_str();
+
+  std::fprintf(f,
+      "#ifndef %s\n"
+      "#define %s\n"
+      "\n"
+      "#include <cstdint>\n"
+      "\n"
+      "#include \"demo/raycast/texture.h\"\n"
+      "\n"
+      "namespace demo {\n"
+      "namespace raycast {\n"
+      "\n"
+      "static constexpr unsigned %s_color_count = %u;\n"
+      "extern std::uint8_t const %s_palette_top[%s_color_count];\n"
+      "extern std::uint8_t const %s_palette_bot[%s_color_count];\n"
+      "\n"
+      "static constexpr unsigned %s_texture_count = %u;\n"
+      "extern Texture const %s_tex[%s_texture_count];\n"
+      "\n"
+      "// Remapping tables for distance shading, from lightest (the identity) to\n"
+      "// darkest.  Only entries for colors used by textures are present.\n"
+      "static constexpr unsigned %s_shade_count = %u;\n"
+      "static constexpr unsigned %s_shaded_color_count = %u;\n"
+      "extern std::uint8_t const\n"
+      "    %s_shade[%s_shade_count][%s_shaded_color_count];\n"
+      "\n"
+      "}  // namespace raycast\n"
+      "}  // namespace demo\n"
+      "\n"
+      "#endif  // %s\n",
+      guard.c_str(), guard.c_str(),
+      n, color_count, n, n, n, n,
+      n, texture_count, n, n,
+      n, shade_levels, n, base_colors, n, n, n,
+      guard.c_str());
+
+  std::fclose(f);
+}
+
+static void write_source(std::string const & path, std::string const & name,
+                         Palette const & palette,
+                         std::vector<std::vector<unsigned>> const & shades,
+                         std::vector<std::vector<unsigned>> const & textures,
+                         std::vector<std::vector<unsigned>> const & sub_palettes) {
+  auto f = std::fopen(path.c_str(), "w");
+  if (!f) fail("can't create %s", path.c_str());
+  auto const n = name.c_str();
+  auto const colors = palette.pairs.size();
+
+  std::fprintf(f,
+      "#include \"demo/raycast/%s.h\"\n"
+      "\n"
+      "namespace demo {\n"
+      "namespace raycast {\n"
+      "\n"
+      "static_assert(Texture::mip_levels == %u,\n"
+      "              \"texture converter and raycaster disagree on mip levels\");\n"
+      "\n",
+      n, mip_levels);
+
+  std::fprintf(f, "std::uint8_t const %s_palette_top[%zu] {\n", n, colors);
+  for (auto pair : palette.pairs) std::fprintf(f, "  0x%x,\n", pair_top(pair));
+  std::fprintf(f, "};\n");
+
+  std::fprintf(f, "std::uint8_t const %s_palette_bot[%zu] {\n", n, colors);
+  for (auto pair : palette.pairs) std::fprintf(f, "  0x%x,\n", pair_bot(pair));
+  std::fprintf(f, "};\n");
+
+  std::fprintf(f, "std::uint8_t const %s_shade[%u][%zu] {\n",
+               n, shade_levels, shades[0].size());
+  for (auto const & table : shades) {
+    std::fprintf(f, "  {\n");
+    for (size_t i = 0; i < table.size(); ++i) {
+      std::fprintf(f, "%s%u,%s", i % 16 ? " " : "    ", table[i],
+                   i % 16 == 15 || i + 1 == table.size() ? "\n" : "");
+    }
+    std::fprintf(f, "  },\n");
+  }
+  std::fprintf(f, "};\n");
+
+  bool const packed = !sub_palettes.empty();
+  for (size_t ti = 0; ti < textures.size(); ++ti) {
+    auto const & tex = textures[ti];
+    std::vector<unsigned> bytes;
+    if (packed) {
+      for (size_t i = 0; i < tex.size(); i += 2) {
+        bytes.push_back(tex[i] | (tex[i + 1] << 4));
+      }
+    } else {
+      bytes = tex;
+    }
+
+    std::fprintf(f, "static std::uint8_t const %s_texels_%zu[%zu] {\n  ",
+                 n, ti, bytes.size());
+    for (size_t i = 0; i < bytes.size(); ++i) {
+      std::fprintf(f, "0x%x, %s", bytes[i], i % 8 == 7 ? "\n  " : "");
+    }
+    std::fprintf(f, "};\n");
+
+    if (packed) {
+      std::fprintf(f, "static std::uint8_t const %s_sub_palette_%zu[16] {\n ",
+                   n, ti);
+      for (auto pi : sub_palettes[ti]) std::fprintf(f, " %u,", pi);
+      std::fprintf(f, "\n};\n");
+    }
+  }
+
+  std::fprintf(f, "Texture const %s_tex[%zu] {\n", n, textures.size());
+  for (size_t ti = 0; ti < textures.size(); ++ti) {
+    if (packed) {
+      std::fprintf(f, "  { %s_texels_%zu, %s_sub_palette_%zu },\n",
+                   n, ti, n, ti);
+    } else {
+      std::fprintf(f, "  { %s_texels_%zu, nullptr },\n", n, ti);
+    }
+  }
+  std::fprintf(f, "};\n");
+
+  std::fprintf(f,
+      "}  // namespace raycast\n"
+      "}  // namespace demo\n");
+
+  std::fclose(f);
+}
+
+
+/*******************************************************************************
+ * Driver
+ */
+
+int main(int argc, char ** argv) {
+  if (argc < 4) {
+    fail("usage: %s <input.pnm> <output-dir> <name> [--4bpp]", argv[0]);
+  }
+  std::string const outdir = argv[2], name = argv[3];
+  bool packed = false;
+  for (int i = 4; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--4bpp") == 0) {
+      packed = true;
+    } else {
+      fail("unknown option %s", argv[i]);
+    }
+  }
+
+  std::fprintf(stderr, "Loading %s...\n", argv[1]);
+  auto const data = read_file(argv[1]);
+  auto const image = PnmReader(data).read();
+
+  if (image.height != tex_height || image.width % tex_width != 0
+      || image.width == 0) {
+    fail("unexpected size %ux%u", image.width, image.height);
+  }
+
+  auto const texture_count = image.width / tex_width;
+  std::fprintf(stderr, "Texture count: %u\n", texture_count);
+
+  std::vector<std::vector<unsigned>> textures;
+  std::vector<unsigned long> histogram(pair_count);
+  for (unsigned ti = 0; ti < texture_count; ++ti) {
+    textures.push_back(texture_pairs(image, ti));
+    for (auto pair : textures.back()) ++histogram[pair];
+  }
+
+  std::vector<Entry> entries;
+  for (unsigned pair = 0; pair < pair_count; ++pair) {
+    if (histogram[pair]) entries.push_back({pair, histogram[pair]});
+  }
+  std::fprintf(stderr, "%zu distinct color pairs.\n", entries.size());
+
+  // Choose the texture colors, then their shades.  If the result doesn't fit
+  // in the palette, binary search for the largest number of texture colors
+  // that does.  (A single texture color plus its shades always fits.)
+  Palette palette;
+  std::vector<std::vector<unsigned>> shades;
+  unsigned k = unsigned(std::min<size_t>(entries.size(), palette_size - 1));
+  if (!build_palette(entries, k, palette, shades)) {
+    std::fprintf(stderr, "Reducing texture colors to fit shades.\n");
+    unsigned lo = 1, hi = k;  // lo always fits, hi never does.
+    while (hi - lo > 1) {
+      auto const mid = (lo + hi) / 2;
+      if (build_palette(entries, mid, palette, shades)) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    build_palette(entries, lo, palette, shades);
+  }
+
+  auto const base_colors = shades[0].size();
+  std::fprintf(stderr, "Success: %zu colors used.\n", palette.pairs.size());
+  std::fprintf(stderr, "%zu texture colors, %zu consumed by shading.\n",
+               base_colors, palette.pairs.size() - base_colors);
+
+  // Map every distinct pair to its nearest texture color.
+  std::vector<unsigned> index(pair_count);
+  for (auto const & e : entries) {
+    index[e.pair] = palette.nearest(e.pair, base_colors);
+  }
+
+  unsigned approximated = 0;
+  for (auto & tex : textures) {
+    for (auto & t : tex) {
+      auto const pi = index[t];
+      if (palette.pairs[pi] != t) ++approximated;
+      t = pi;
+    }
+  }
+
+  std::vector<std::vector<unsigned>> sub_palettes;
+  if (packed) {
+    for (auto & tex : textures) {
+      sub_palettes.emplace_back();
+      approximated += quantize16(palette, tex, sub_palettes.back());
+    }
+  }
+
+  if (approximated) {
+    std::fprintf(stderr, "%u texels approximated by nearest color.\n",
+                 approximated);
+  }
+
+  std::fprintf(stderr, "Output going into %s.\n", outdir.c_str());
+  write_header(outdir + "/" + name + ".h", name,
+               unsigned(palette.pairs.size()), texture_count,
+               unsigned(base_colors));
+  write_source(outdir + "/" + name + ".cc", name, palette, shades, textures,
+               sub_palettes);
+  return 0;
+}
@@ -19,6 +19,7 @@
 
 #include "demo/input.h"
 #include "demo/raycast/config.h"
+#include "demo/raycast/level.h"
 #include "demo/raycast/map.h"
 #include "demo/raycast/tex.h"
 #include "demo/raycast/texture.h"
@@ -32,10 +33,15 @@ namespace raycast {
 
 using vga::Pixel;
 
-RayCast::RayCast()
-  : _pos{10, 10},
+RayCast::RayCast() : RayCast(level_map) {}
+
+RayCast::RayCast(Map const & map)
+  : _map(map),
+    _pos{10, 10},
     _dir{-1, 0},
-    _plane{0, config::fov} {
+    _plane{0, config::fov},
+    _turn{0},
+    _travel{0} {
   auto fb = _rasterizer.get_fg_buffer();
   for (unsigned y = 0; y < config::rows/2; ++y) {
     for (unsigned x = 0; x < config::cols; ++x) {
@@ -55,8 +61,14 @@ void RayCast::configure_band_list() {
   vga::configure_band_list(_bands);
 }
 
-static unsigned map_fetch(int x, int y) {
-  return canned_map.fetch(x, y);
+/*
+ * Counts how many of the boundary crossings along one axis -- the first at
+ * distance 'side', then every 'delta' after -- happen before distance
+ * 'limit', up to a maximum of 'reach'.
+ */
+static int crossings_before(float side, float delta, float limit, int reach) {
+  if (side >= limit) return 0;
+  return etl::min(math::ceil((limit - side) / delta), reach);
 }
 
 static int same(Hit::Side side, Vec2i v) {
@@ -137,7 +149,33 @@ Hit RayCast::cast(float x) const {
       side = Hit::Side::y;
     }
 
-    texnum = map_fetch(map_pos.x, map_pos.y);
+    auto const cell = _map.cell(map_pos.x, map_pos.y);
+    texnum = cell & Map::tile_mask;
+
+    if (texnum == 0) {
+      // We're in open space.  Every tile within (clearance - 1) of this one
+      // along both axes is also open, so the ray can cross that many tile
+      // boundaries along each axis without checking the map.  Find the
+      // distance at which it would first cross a boundary outside that
+      // region, and take all the crossings before it in one go.
+      //
+      // This costs a division, so it only pays off when we can skip more
+      // than one tile.
+      auto const reach = int(cell >> Map::clearance_shift) - 1;
+      if (reach > 1) {
+        auto const limit = etl::min(side_dist.x + reach * delta_dist.x,
+                                    side_dist.y + reach * delta_dist.y);
+        auto const nx = crossings_before(side_dist.x, delta_dist.x,
+                                         limit, reach);
+        auto const ny = crossings_before(side_dist.y, delta_dist.y,
+                                         limit, reach);
+
+        side_dist.x += nx * delta_dist.x;
+        side_dist.y += ny * delta_dist.y;
+        map_pos.x += nx * step.x;
+        map_pos.y += ny * step.y;
+      }
+    }
   } while (texnum == 0);
 
   // Decrement the texture number for zero-based texture array.
@@ -189,78 +227,247 @@ bool RayCast::render_frame(unsigned frame) {
 
   auto const fb = _rasterizer.get_bg_buffer();
 
-  // Produce pixels in vertical columns, once for each X coordinate of the
-  // display.
-  for (unsigned x = 0; x < config::cols; ++x) {
-    // Convert the integer x coordinate to the range (-1, 1) to simplify the
-    // casting math.
-    auto const fx = 2 * x / float(config::cols) - 1;
-    // Figure out where in the map we hit.  Note that a hit is guaranteed: the
-    // map is closed (or is assumed to be closed).
-    auto const hit = cast(fx);
-
-    // Given the distance of the hit, apply simple perspective projection to
-    // find the height of the textured pixel column we need to draw.
-    // TODO: int(std::abs(x)) may actually be faster
-    auto const col_height = std::abs(int(config::rows / hit.distance));
-    // Get the Y coordinate of the first pixel drawn, limiting it to the top of
-    // the display.
-    auto const top = etl::max(-col_height / 2 + config::rows / 2, 0);
+  if (!config::interleave || frame == 0
+      || std::abs(_turn) > config::max_interleave_turn
+      || _travel > config::max_interleave_travel) {
+    // Produce pixels in vertical columns, once for each X coordinate of the
+    // display.  When interleaving, this also covers frames where the camera
+    // turns or moves too far for last frame's columns to line up with this
+    // one's.
+    for (unsigned x = 0; x < config::cols; ++x) {
+      draw_column(fb, x);
+    }
+  } else {
+    // Cast only the columns of this frame's parity, and carry the others
+    // over from the frame we just finished (which, having just flipped, is
+    // now in the foreground).  Their entries in the depth buffer are carried
+    // over implicitly.
+    auto const prev = _rasterizer.get_fg_buffer();
+    auto const parity = frame & 1;
+    for (unsigned x = 0; x < config::cols; x += 2) {
+      draw_column(fb, x + parity);
+      copy_column(fb, x + (parity ^ 1), prev, x + (parity ^ 1));
+    }
+  }
+
+  draw_sprites(fb);
 
-    vga::msig_e_set(1);
+  return true;
+}
+
+/*
+ * Texel fetch policies for draw_texels, for unpacked and packed textures.
+ */
+struct UnpackedFetch {
+  std::uint8_t const * col;
+
+  std::uint8_t operator()(unsigned y) const {
+    return col[y];
+  }
+};
 
-    // Draw the ceiling/floor.  This formulation of the loop seems to generate
-    // the most efficient code on GCC 4.8.3.
-    for (auto fill = &fb[x];
-         fill != &fb[top * config::cols + x];
-         fill += config::cols) {
-      *fill = 0;
+struct PackedFetch {
+  std::uint8_t const * col;
+  std::uint8_t const * sub_palette;
+
+  std::uint8_t operator()(unsigned y) const {
+    return Texture::unpack(col, sub_palette, y);
+  }
+};
+
+/*
+ * Draws 'count' pixels down a column of the framebuffer starting at 'out',
+ * taking texels from 'fetch' at Y coordinates starting at 'tex_y' and
+ * advancing by 'step' per pixel.  If 'remap' is not null, each texel is
+ * passed through it on the way.
+ *
+ * The texture coordinate is advanced by repeated adds, rather than computed
+ * as y * m + b.  This might seem counter-intuitive, since the M4 has a fused
+ * multiply add operation that can evaluate the full equation nearly as fast
+ * as an add.  However, using that really pessimizes GCC 4.8.3's output.  The
+ * loop gains a lot of added fat and becomes 30% or so slower.
+ */
+template <typename Fetch>
+static void draw_texels(Pixel * out, unsigned count, Fetch fetch,
+                        std::uint8_t const * remap,
+                        float tex_y, float step) {
+  if (remap) {
+    for (unsigned i = 0; i < count; ++i) {
+      *out = remap[fetch(int(tex_y))];
+      out += config::cols;
+      tex_y += step;
+    }
+  } else {
+    for (unsigned i = 0; i < count; ++i) {
+      *out = fetch(int(tex_y));
+      out += config::cols;
+      tex_y += step;
     }
+  }
+}
+
+/*
+ * Picks the distance shading level for something 'distance' tiles away,
+ * plus 'extra' levels, clamped to the darkest available.
+ */
+static unsigned shade_for(float distance, unsigned extra = 0) {
+  auto const level = unsigned(distance * (1 / config::shade_distance)) + extra;
+  return etl::min(level, tex_shade_count - 1);
+}
+
+void RayCast::draw_column(Pixel * fb, unsigned x) {
+  // Convert the integer x coordinate to the range (-1, 1) to simplify the
+  // casting math.
+  auto const fx = 2 * x / float(config::cols) - 1;
+  // Figure out where in the map we hit.  Note that a hit is guaranteed: the
+  // map is closed (or is assumed to be closed).
+  auto const hit = cast(fx);
+  _depth[x] = hit.distance;
+
+  // Given the distance of the hit, apply simple perspective projection to
+  // find the height of the textured pixel column we need to draw.
+  // TODO: int(std::abs(x)) may actually be faster
+  auto const col_height = std::abs(int(config::rows / hit.distance));
+  // Get the Y coordinate of the first pixel drawn, limiting it to the top of
+  // the display.
+  auto const top = etl::max(-col_height / 2 + config::rows / 2, 0);
+
+  vga::msig_e_set(1);
+
+  // Draw the ceiling/floor.  This formulation of the loop seems to generate
+  // the most efficient code on GCC 4.8.3.
+  for (auto fill = &fb[x];
+       fill != &fb[top * config::cols + x];
+       fill += config::cols) {
+    *fill = 0;
+  }
+
+  // For each y coordinate between top and the middle of the screen, the
+  // tex_y value should be
+  //
+  //   tex_y = y * m + b
+  //
+  // for the values of m and b given below.
+  //
+  // However, we aren't going to write that in the loop.  Instead, we'll
+  // manually strength-reduce the formula by changing the loop to repeated
+  // adds.  See draw_texels.
+  auto const m = float(config::apparent_tex_height) / col_height;
+  auto const b = (-config::rows / 2.f + col_height / 2.f) * m;
+
+  // Pick the mip level that steps through roughly one texel per pixel, and
+  // scale the texture coordinates to match it.
+  auto const level = Texture::level_for(m);
+  auto const scale = 1.f / (1u << level);
+  auto const tex_y = (top * m + b) * scale;
+
+  auto const & tex = tex_tex[hit.texture];
+  auto const col = tex.column(level, hit.tex_u >> level);
+  // Fade walls with distance, and darken Y-aligned walls by an additional
+  // level (Wolfenstein-style).  Level 0 is the identity, so we skip the
+  // remapping entirely for close X-aligned walls.
+  auto const shade =
+      shade_for(hit.distance, hit.side == Hit::Side::y ? 1 : 0);
+  auto const remap = shade ? tex_shade[shade] : nullptr;
+  auto const out = &fb[top * config::cols + x];
+  auto const count = unsigned(config::rows/2 - top);
+
+  if (tex.sub_palette) {
+    draw_texels(out, count, PackedFetch{col, tex.sub_palette},
+                remap, tex_y, m * scale);
+  } else {
+    draw_texels(out, count, UnpackedFetch{col}, remap, tex_y, m * scale);
+  }
+
+  vga::msig_e_clear(1);
+}
+
+void RayCast::copy_column(Pixel * dst, unsigned dst_x,
+                          Pixel const * src, unsigned src_x) {
+  for (unsigned y = 0; y < config::rows/2; ++y) {
+    dst[y * config::cols + dst_x] = src[y * config::cols + src_x];
+  }
+}
 
-    // For each y coordinate between top and the middle of the screen, the
-    // tex_y value should be
-    //
-    //   tex_y = y * m + b
-    //
-    // for the values of m and b given below.
-    //
-    // However, we aren't going to write that in the loop below.  Instead, we'll
-    // manually strength-reduce the formula by changing the loop to repeated
-    // adds.
-    //
-    // This might seem counter-intuitive, since the M4 has a fused multiply add
-    // operation that can evaluate the full equation nearly as fast as an add.
-    // However, using that really pessimizes GCC 4.8.3's output.  The loop
-    // gains a lot of added fat and becomes 30% or so slower.
+void RayCast::draw_sprites(Pixel * fb) const {
+  // A sprite after transformation into camera space.
+  struct Projected {
+    float depth;     // Distance along _dir, comparable to Hit::distance.
+    float center_x;  // Column of the sprite's center, possibly off-screen.
+    unsigned texture;
+  };
+
+  // Transform each sprite and insertion-sort it into back-to-front order, so
+  // that nearer sprites paint over farther ones.
+  Projected order[canned_sprite_count];
+  unsigned count = 0;
+
+  // Inverse of the camera matrix [_plane _dir], which takes camera-space
+  // coordinates to map coordinates.
+  auto const inv_det = 1 / (_plane.x * _dir.y - _dir.x * _plane.y);
+
+  for (auto const & sprite : canned_sprites) {
+    auto const rel = sprite.pos - _pos;
+    auto const depth = inv_det * (_plane.x * rel.y - _plane.y * rel.x);
+    if (depth < config::sprite_min_depth) continue;  // Behind us.
+
+    auto const lateral = inv_det * (_dir.y * rel.x - _dir.x * rel.y);
+    auto const center_x = (lateral / depth + 1) * (config::cols / 2);
+
+    unsigned i = count++;
+    for (; i > 0 && order[i - 1].depth < depth; --i) order[i] = order[i - 1];
+    order[i] = { depth, center_x, sprite.texture };
+  }
+
+  for (unsigned i = 0; i < count; ++i) {
+    auto const & p = order[i];
+
+    // A sprite is one tile wide and one tile high.  The width is derived
+    // from the FOV, the height exactly as for walls.
+    auto const width = config::cols / (2 * config::fov * p.depth);
+    auto const left = p.center_x - width / 2;
+
+    auto const x0 = etl::max(math::ceil(left), 0);
+    auto const x1 = etl::min(int(left + width), config::cols);
+    if (x0 >= x1) continue;  // Entirely off-screen.
+
+    auto const col_height = int(config::rows / p.depth);
+    auto const top = etl::max(-col_height / 2 + config::rows / 2, 0);
+
+    // See draw_column for the derivation of these.
     auto const m = float(config::apparent_tex_height) / col_height;
     auto const b = (-config::rows / 2.f + col_height / 2.f) * m;
-    auto tex_y = top * m + b;
-
-    if (hit.side == Hit::Side::y) {
-      // Darken the texture slightly (Wolfenstein-style)
+    auto const level = Texture::level_for(m);
+    auto const scale = 1.f / (1u << level);
+    auto const tex_y0 = (top * m + b) * scale;
+    auto const step = m * scale;
+
+    auto const & tex = tex_tex[p.texture];
+    auto const remap = tex_shade[shade_for(p.depth)];
+    auto const du = config::tex_width / width;
+
+    for (int x = x0; x < x1; ++x) {
+      // Clip against the depth buffer before touching the texture, so that
+      // hidden sprites cost only a compare per column.
+      if (p.depth >= _depth[x]) continue;
+
+      auto const tex_u = unsigned((x - left) * du) >> level;
+      auto tex_y = tex_y0;
       for (unsigned y = top; y < config::rows/2; ++y) {
-        fb[y * config::cols + x] = tex_darken[
-          tex_tex[hit.texture].fetch(hit.tex_u, int(tex_y))];
-        tex_y += m;
-      }
-    } else {
-      // Render the texture faithfully.
-      for (unsigned y = top; y < config::rows/2; ++y) {
-        fb[y * config::cols + x] =
-          tex_tex[hit.texture].fetch(hit.tex_u, int(tex_y));
-        tex_y += m;
+        auto const texel = tex.fetch(level, tex_u, int(tex_y));
+        if (texel) fb[y * config::cols + x] = remap[texel];
+        tex_y += step;
       }
     }
-
-    vga::msig_e_clear(1);
   }
-
-  return true;
 }
 
 void RayCast::update_camera() {
   auto const j = read_joystick();
 
+  _turn = 0;
+  _travel = 0;
+
   if (j & JoyBits::up)   move(_dir * +0.1f);
   if (j & JoyBits::down) move(_dir * -0.1f);
 
@@ -274,13 +481,15 @@ void RayCast::rotate(float a) {
     { sinf(a), cosf(a) },
   };
   _dir = m * _dir;
+  _turn += a;
   _plane = Vec2f{_dir.y, -_dir.x} * config::fov;
 }
 
 void RayCast::move(Vec2f delta) {
   auto new_pos = _pos + delta;
-  if (map_fetch(math::floor(new_pos.x), math::floor(new_pos.y)) == 0) {
+  if (_map.fetch(math::floor(new_pos.x), math::floor(new_pos.y)) == 0) {
     _pos = new_pos;
+    _travel += sqrtf(delta.x * delta.x + delta.y * delta.y);
   }
 }
 
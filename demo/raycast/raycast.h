@@ -10,12 +10,16 @@
 #include "demo/scene.h"
 #include "demo/raycast/config.h"
 #include "demo/raycast/hit.h"
+#include "demo/raycast/map.h"
 
 namespace demo {
 namespace raycast {
 
 class RayCast : public Scene {
 public:
+  // Starts the camera at (10, 10) in the given map, which defaults to the
+  // level from level.map.
+  explicit RayCast(Map const &);
   RayCast();
 
   void configure_band_list() override;
@@ -37,16 +41,31 @@ private:
     { &_mirror,     config::disp_rows / 2, nullptr },
   };
 
+  Map const & _map;
+
   etl::math::Vec2f _pos;     // Position of camera within map.
   etl::math::Vec2f _dir;     // Direction vector of camera (unit).
   etl::math::Vec2f _plane;   // Plane vector; perpendicular to _dir,
                              // length determines FOV.
 
+  // Perpendicular distance to the wall drawn in each column of the current
+  // frame, used to occlude sprites.
+  float _depth[config::cols];
+
+  // Angle the camera turned, and distance it moved, during the current
+  // frame.
+  float _turn;
+  float _travel;
+
   void update_camera();
   void rotate(float a);
   void move(etl::math::Vec2f);
 
   Hit cast(float x) const;
+  void draw_column(vga::Pixel * fb, unsigned x);
+  static void copy_column(vga::Pixel * dst, unsigned dst_x,
+                          vga::Pixel const * src, unsigned src_x);
+  void draw_sprites(vga::Pixel * fb) const;
 };
 
 }  // namespace raycast
@@ -0,0 +1,25 @@
+#ifndef DEMO_RAYCAST_SPRITE_H
+#define DEMO_RAYCAST_SPRITE_H
+
+#include "etl/math/vector.h"
+
+namespace demo {
+namespace raycast {
+
+/*
+ * A billboard: an object in the map that is always drawn facing the camera.
+ *
+ * Sprites use the same column-major Texture format as the walls, and occupy
+ * one tile's worth of height when projected.  Texels with index 0 are
+ * transparent.  (Index 0 is reserved for the ceiling/floor color by the
+ * texture converter, so it never appears in real texture data.)
+ */
+struct Sprite {
+  etl::math::Vec2f pos;
+  unsigned texture;
+};
+
+}  // namespace raycast
+}  // namespace demo
+
+#endif  // DEMO_RAYCAST_SPRITE_H
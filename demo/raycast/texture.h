@@ -1,16 +1,68 @@
 #ifndef DEMO_RAYCAST_TEXTURE_H
 #define DEMO_RAYCAST_TEXTURE_H
 
+#include <cstdint>
+
 #include "demo/raycast/config.h"
 
 namespace demo {
 namespace raycast {
 
+/*
+ * A wall (or sprite) texture, as generated by process_textures.cc.
+ *
+ * Texels are stored column-major, since we draw walls in vertical strips.
+ * Each texture carries a chain of mip levels: level 0 is tex_width by
+ * tex_height, and each subsequent level halves both dimensions.  The levels
+ * are stored back to back.
+ *
+ * Texels are either 8-bit palette indices or, if sub_palette is not null,
+ * 4-bit indices into a per-texture 16-entry sub-palette of palette indices.
+ * Packed texels come two to a byte, with even Y coordinates in the low
+ * nibble.
+ */
 struct Texture {
-  std::uint8_t indices[config::tex_width * config::tex_height];
+  static constexpr unsigned mip_levels = 4;
+
+  std::uint8_t const * texels;
+  std::uint8_t const * sub_palette;
+
+  // Offset, in texels, of the start of a mip level.
+  static constexpr unsigned level_offset(unsigned level) {
+    return level == 0
+        ? 0
+        : level_offset(level - 1)
+            + (config::tex_width >> (level - 1))
+              * (config::tex_height >> (level - 1));
+  }
+
+  // Picks the mip level to use when each screen pixel spans the given number
+  // of level-0 texels.
+  static unsigned level_for(float texels_per_pixel) {
+    auto const n = unsigned(texels_per_pixel);
+    if (n < 2) return 0;
+    auto const level = unsigned(31 - __builtin_clz(n));
+    return level < mip_levels ? level : mip_levels - 1;
+  }
+
+  // Returns the texels of column x at a given mip level.  For packed
+  // textures, this is a pointer to pairs of texels.
+  inline std::uint8_t const * column(unsigned level, unsigned x) const {
+    auto const offset =
+        level_offset(level) + x * (config::tex_height >> level);
+    return texels + (sub_palette ? offset / 2 : offset);
+  }
+
+  inline std::uint8_t fetch(unsigned level, unsigned x, unsigned y) const {
+    auto const col = column(level, x);
+    return sub_palette ? unpack(col, sub_palette, y) : col[y];
+  }
 
-  inline std::uint8_t fetch(unsigned x, unsigned y) const {
-    return indices[x * config::tex_height + y];
+  // Looks up texel y within a packed column.
+  static inline std::uint8_t unpack(std::uint8_t const * col,
+                                    std::uint8_t const * sub_palette,
+                                    unsigned y) {
+    return sub_palette[(col[y / 2] >> ((y & 1) * 4)) & 0xF];
   }
 };
 
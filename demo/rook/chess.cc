@@ -0,0 +1,91 @@
+#include "demo/rook/chess.h"
+
+#include "etl/math/affine_transform.h"
+#include "etl/math/matrix.h"
+
+#include "demo/input.h"
+
+using etl::math::Vec2i;
+using etl::math::Vec3f;
+using etl::math::Vec4f;
+
+namespace xf = etl::math::affine_transform;
+
+namespace demo {
+namespace rook {
+
+// Ranks of the board holding pieces at the start of a game.
+static constexpr unsigned occupied_ranks[] {0, 1, 6, 7};
+
+ChessSet::ChessSet()
+  : _view(config::cols/2, config::wireframe_rows/2,
+          config::chess_scale, config::chess_eye_distance) {
+  // Tip the board toward the viewer, who would otherwise look straight down
+  // on it.
+  _view.model = xf::rotate_x(-config::chess_tilt);
+  _view.model_inverse = xf::rotate_x(+config::chess_tilt);
+
+  unsigned n = 0;
+  for (auto rank : occupied_ranks) {
+    for (unsigned file = 0; file < 8; ++file) {
+      _pieces[n++] = {
+        &_rook,
+        {
+          (float(file) - 3.5f) * config::chess_square,
+          (float(rank) - 3.5f) * config::chess_square,
+          0,
+        },
+      };
+    }
+  }
+}
+
+void ChessSet::configure_band_list() {
+  vga::configure_band_list(_bands);
+}
+
+__attribute__((section(".ramcode.chess_run")))
+bool ChessSet::render_frame(unsigned) {
+  auto const continuing = !user_button_pressed();
+  _wireframe.present();
+  _view.update(read_joystick(), center_button_pressed());
+
+  auto const m = _view.transform();
+  auto const eye = _view.eye();
+  _wireframe.erase();
+
+  for (auto mesh : _meshes) {
+    mesh->select_lod(m);
+    mesh->transform_vertices(m);
+  }
+
+  auto const project = [&m](Vec3f const &p) {
+    auto const v = m * Vec4f{p.x, p.y, p.z, 1};
+    return Vec2i{static_cast<int>(v.x / v.w), static_cast<int>(v.y / v.w)};
+  };
+  // The meshes were transformed in place at the board's center; each piece
+  // is moved from there to where its own position projects.
+  auto const center = project(Vec3f{0, 0, 0});
+
+  auto const view = _wireframe.view();
+  for (auto const & piece : _pieces) {
+    auto const p = project(piece.position);
+    Vec2i const offset {p.x - center.x, p.y - center.y};
+    auto const mesh = piece.mesh;
+
+    _wireframe.cover(mesh->min_x + offset.x, mesh->min_y + offset.y,
+                     mesh->max_x + offset.x, mesh->max_y + offset.y);
+    mesh->draw_edges(view,
+                     Vec3f{
+                       eye.x - piece.position.x,
+                       eye.y - piece.position.y,
+                       eye.z - piece.position.z,
+                     },
+                     offset);
+  }
+
+  return continuing;
+}
+
+}  // namespace rook
+}  // namespace demo
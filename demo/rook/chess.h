@@ -0,0 +1,64 @@
+#ifndef DEMO_ROOK_CHESS_H
+#define DEMO_ROOK_CHESS_H
+
+#include "etl/math/vector.h"
+
+#include "vga/vga.h"
+#include "vga/rast/solid_color.h"
+
+#include "demo/scene.h"
+#include "demo/rook/config.h"
+#include "demo/rook/model.h"
+#include "demo/rook/rook.h"
+
+namespace demo {
+namespace rook {
+
+/*
+ * Renders a full set of chess pieces in wireframe.
+ *
+ * Each distinct model's vertices are transformed once per frame, and every
+ * piece using it is drawn from those, moved into place on the screen.  This
+ * treats each piece as if it were as far from the eye as the center of the
+ * board (weak perspective), which is close enough from far away, and means
+ * the transform cost depends on the number of models, not pieces.
+ */
+class ChessSet : public Scene {
+public:
+  ChessSet();
+
+  void configure_band_list() override;
+  bool render_frame(unsigned) override;
+
+private:
+  static constexpr unsigned piece_count = 32;
+
+  struct Piece {
+    WireMesh * mesh;
+    etl::math::Vec3f position;  // On the board, in model units.
+  };
+
+  vga::rast::SolidColor _blue{config::cols, 0b010000};
+  Wireframe _wireframe;
+
+  vga::Band const _bands[3] {
+    { &_blue,                 config::top_margin,     &_bands[1] },
+    { &_wireframe.rasterizer, config::wireframe_rows, &_bands[2] },
+    { &_blue,                 config::bottom_margin + config::text_rows,
+                              nullptr },
+  };
+
+  // Only the rook has been compiled so far, so it stands in for every piece.
+  // Others go in compile_stl's list and get a mesh here.
+  WireMesh _rook{rook_model};
+  WireMesh * const _meshes[1] { &_rook };
+
+  Piece _pieces[piece_count];
+
+  View _view;
+};
+
+}  // namespace rook
+}  // namespace demo
+
+#endif  // DEMO_ROOK_CHESS_H
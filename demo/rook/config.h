@@ -17,6 +17,33 @@ static constexpr unsigned
   bottom_margin = 84,
   text_rows = 16;
 
+// Layout of the filled scene, which renders at half resolution in each
+// direction to fit two 8bpp pages in RAM.
+static constexpr unsigned
+  fill_top_margin = 150,
+  fill_rows = 300,
+  fill_bottom_margin = 150,
+  fill_div = 2;
+
+// Distance from the eye to the model's origin, and the factor by which the
+// center button backs it off.
+static constexpr float
+  eye_distance = 70,
+  zoom_out = 3;
+
+// Lines the wireframe may draw per pixel of the model's projected radius.  It
+// uses the most detailed level of the model within this budget.
+static constexpr float lod_edges_per_pixel = 28;
+
+// Layout of the chess set scene: size of a board square in model units, and
+// a view from far enough away that pieces change little in size across the
+// board.
+static constexpr float
+  chess_square = 30,
+  chess_eye_distance = 900,
+  chess_scale = 1100,
+  chess_tilt = 1;
+
 }  // namespace config
 }  // namespace rook
 }  // namespace demo
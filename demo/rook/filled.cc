@@ -0,0 +1,233 @@
+#include "demo/rook/filled.h"
+
+#include "etl/algorithm.h"
+#include "etl/math/matrix.h"
+#include "etl/math/vector.h"
+
+#include "math/conversion.h"
+
+#include "vga/arena.h"
+#include "vga/measurement.h"
+
+#include "demo/input.h"
+#include "demo/rook/model.h"
+
+using etl::math::Vec3f;
+using etl::math::Vec4f;
+
+namespace demo {
+namespace rook {
+
+using vga::Pixel;
+
+static_assert(max_triangle_count < 0xFFFF,
+              "face indices must fit in 16 bits, with one value to spare");
+
+static constexpr int
+  fb_cols = config::cols / config::fill_div,
+  fb_rows = config::fill_rows / config::fill_div;
+
+// Palette index of the background.  Faces use the entries after it.
+static constexpr Pixel background = 0;
+
+/*
+ * Face colors, from least to most brightly lit.  This is a warm gray ramp,
+ * which gets more distinct steps out of two bits per channel than pure gray.
+ */
+static constexpr Pixel shade_ramp[] {
+  0b000000, 0b000001, 0b000101, 0b010101, 0b010110,
+  0b011010, 0b101010, 0b101011, 0b101111, 0b111111,
+};
+static constexpr unsigned shade_count = sizeof(shade_ramp);
+
+// Shade used for faces that get no direct light.
+static constexpr unsigned ambient_shade = 2;
+
+// Direction toward the light, relative to the viewer: over the viewer's
+// shoulder.  Unit length.
+static constexpr Vec3f light_direction {-0.4f, -0.5f, 0.768f};
+
+FilledRook::FilledRook()
+  : _view(fb_cols / 2, fb_rows / 2,
+          // Same proportion of the band as the wireframe.
+          fb_rows * 3 / 4.f),
+    _screen(vga::arena_new_array<ScreenVertex>(
+        rook_model.mesh().vertex_count)),
+    _next(vga::arena_new_array<std::uint16_t>(rook_model.triangle_count)),
+    _color(vga::arena_new_array<std::uint8_t>(rook_model.triangle_count)) {
+  auto const palette = _rasterizer.get_palette();
+  palette[background] = 0b010000;
+  for (unsigned i = 0; i < shade_count; ++i) {
+    palette[background + 1 + i] = shade_ramp[i];
+  }
+
+  // Render_frame flips first, so both pages need to start out clear.
+  for (unsigned page = 0; page < 2; ++page) {
+    auto const fb = _rasterizer.get_bg_buffer();
+    for (int i = 0; i < fb_cols * fb_rows; ++i) fb[i] = background;
+    _rasterizer.flip_now();
+  }
+}
+
+void FilledRook::configure_band_list() {
+  vga::configure_band_list(_bands);
+}
+
+/*
+ * Projects every vertex (as in Wireframe::transform_vertices) and finds its
+ * squared distance from the eye.  Reports the range of distances through
+ * 'near' and 'far'.
+ */
+__attribute__((section(".ramcode.filled_transform")))
+void FilledRook::transform(float & near, float & far) {
+  auto const m = _view.transform();
+  auto const eye = _view.eye();
+  auto const & mesh = rook_model.mesh();
+
+  Vec4f const c0 = m * Vec4f{1, 0, 0, 0},
+              c1 = m * Vec4f{0, 1, 0, 0},
+              c2 = m * Vec4f{0, 0, 1, 0},
+              c3 = m * Vec4f{0, 0, 0, 1};
+
+  near = far = 0;
+  for (unsigned i = 0; i < mesh.vertex_count; ++i) {
+    auto const v = mesh.vertex(i);
+    auto const x = c0.x * v.x + c1.x * v.y + c2.x * v.z + c3.x;
+    auto const y = c0.y * v.x + c1.y * v.y + c2.y * v.z + c3.y;
+    auto const w = c0.w * v.x + c1.w * v.y + c2.w * v.z + c3.w;
+    auto const inv_w = 1 / w;
+
+    auto const dx = v.x - eye.x, dy = v.y - eye.y, dz = v.z - eye.z;
+    auto const depth = dx * dx + dy * dy + dz * dz;
+
+    _screen[i] = { x * inv_w, y * inv_w, depth };
+
+    if (i == 0) {
+      near = far = depth;
+    } else {
+      near = etl::min(near, depth);
+      far = etl::max(far, depth);
+    }
+  }
+}
+
+/*
+ * Culls faces pointing away from the eye, shades the rest, and sorts them
+ * into depth buckets for painting.
+ */
+__attribute__((section(".ramcode.filled_sort_faces")))
+void FilledRook::sort_faces(float near, float far) {
+  for (auto & b : _buckets) b = end_of_bucket;
+
+  auto const eye = _view.eye();
+  auto const light = _view.to_model(light_direction);
+  // A face's depth is the mean of its vertices', so it lands in [near, far].
+  auto const scale = (bucket_count - 1) / etl::max(far - near, 1.f) / 3;
+
+  auto const & mesh = rook_model.mesh();
+  for (unsigned t = 0; t < rook_model.triangle_count; ++t) {
+    auto const & tri = rook_model.triangles[t];
+    Vec3f const n {rook_model.triangle_normals[t]};
+    auto const a = mesh.vertex(tri[0]);
+
+    auto const facing = n.x * (eye.x - a.x)
+                      + n.y * (eye.y - a.y)
+                      + n.z * (eye.z - a.z);
+    if (facing <= 0) continue;
+
+    auto const lambert =
+        etl::max(n.x * light.x + n.y * light.y + n.z * light.z, 0.f);
+    auto const shade =
+        ambient_shade + unsigned(lambert * (shade_count - 1 - ambient_shade)
+                                 + 0.5f);
+    _color[t] = std::uint8_t(background + 1 + shade);
+
+    auto const depth = _screen[tri[0]].depth
+                     + _screen[tri[1]].depth
+                     + _screen[tri[2]].depth;
+    auto const bucket = etl::min(unsigned((depth - 3 * near) * scale),
+                                 bucket_count - 1);
+    _next[t] = _buckets[bucket];
+    _buckets[bucket] = std::uint16_t(t);
+  }
+}
+
+using ScreenVertex = FilledRook::ScreenVertex;
+
+/*
+ * Fills a triangle with a solid color, covering the pixels whose centers are
+ * inside it (with a top-left fill convention, so that faces sharing an edge
+ * neither overlap nor leave gaps).  Clips to the framebuffer.
+ */
+__attribute__((section(".ramcode.filled_fill_triangle")))
+static void fill_triangle(Pixel * fb,
+                          ScreenVertex const * a,
+                          ScreenVertex const * b,
+                          ScreenVertex const * c,
+                          Pixel color) {
+  // Sort vertices from top to bottom.
+  if (b->y < a->y) { auto t = a; a = b; b = t; }
+  if (c->y < a->y) { auto t = a; a = c; c = t; }
+  if (c->y < b->y) { auto t = b; b = c; c = t; }
+
+  auto const slope = [](ScreenVertex const * p, ScreenVertex const * q) {
+    return q->y > p->y ? (q->x - p->x) / (q->y - p->y) : 0.f;
+  };
+  auto const long_slope = slope(a, c);
+  auto const top_slope = slope(a, b);
+  auto const bottom_slope = slope(b, c);
+
+  auto const y0 = etl::max(math::ceil(a->y - 0.5f), 0);
+  auto const y1 = etl::min(math::ceil(c->y - 0.5f), fb_rows);
+
+  for (int y = y0; y < y1; ++y) {
+    auto const py = y + 0.5f;
+    auto x_long = a->x + (py - a->y) * long_slope;
+    auto x_short = py < b->y ? a->x + (py - a->y) * top_slope
+                             : b->x + (py - b->y) * bottom_slope;
+    if (x_short < x_long) {
+      auto const t = x_long;
+      x_long = x_short;
+      x_short = t;
+    }
+
+    auto const x0 = etl::max(math::ceil(x_long - 0.5f), 0);
+    auto const x1 = etl::min(math::ceil(x_short - 0.5f), fb_cols);
+    auto row = fb + y * fb_cols;
+    for (int x = x0; x < x1; ++x) row[x] = color;
+  }
+}
+
+__attribute__((section(".ramcode.filled_draw_faces")))
+void FilledRook::draw_faces(Pixel * fb) {
+  // Paint from the farthest bucket forward.
+  for (unsigned b = bucket_count; b-- > 0;) {
+    for (auto t = _buckets[b]; t != end_of_bucket; t = _next[t]) {
+      auto const & tri = rook_model.triangles[t];
+      fill_triangle(fb, &_screen[tri[0]], &_screen[tri[1]], &_screen[tri[2]],
+                    _color[t]);
+    }
+  }
+}
+
+__attribute__((section(".ramcode.filled_run")))
+bool FilledRook::render_frame(unsigned) {
+  auto const continuing = !user_button_pressed();
+  _rasterizer.flip_now();
+  _view.update(read_joystick(), center_button_pressed());
+
+  auto const fb = _rasterizer.get_bg_buffer();
+  for (int i = 0; i < fb_cols * fb_rows; ++i) fb[i] = background;
+
+  vga::msig_e_set(1);
+  float near, far;
+  transform(near, far);
+  sort_faces(near, far);
+  draw_faces(fb);
+  vga::msig_e_clear(1);
+
+  return continuing;
+}
+
+}  // namespace rook
+}  // namespace demo
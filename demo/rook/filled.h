@@ -0,0 +1,71 @@
+#ifndef DEMO_ROOK_FILLED_H
+#define DEMO_ROOK_FILLED_H
+
+#include <cstdint>
+
+#include "vga/vga.h"
+#include "vga/rast/palette8.h"
+#include "vga/rast/solid_color.h"
+
+#include "demo/scene.h"
+#include "demo/rook/config.h"
+#include "demo/rook/rook.h"
+
+namespace demo {
+namespace rook {
+
+/*
+ * Renders the rook as flat-shaded polygons, rather than a wireframe.
+ *
+ * Faces pointing away from the eye are culled, and the rest are lit by a
+ * single directional light (Lambert).  Hidden surfaces are handled by the
+ * painter's algorithm: faces are bucketed by depth and drawn back to front.
+ */
+class FilledRook : public Scene {
+public:
+  // A vertex after projection, plus its squared distance from the eye, which
+  // orders the faces for painting.
+  struct ScreenVertex {
+    float x, y;
+    float depth;
+  };
+
+  FilledRook();
+
+  void configure_band_list() override;
+  bool render_frame(unsigned) override;
+
+private:
+  static constexpr unsigned bucket_count = 256;
+  static constexpr std::uint16_t end_of_bucket = 0xFFFF;
+
+  vga::rast::SolidColor _blue{config::cols, 0b010000};
+  vga::rast::Palette8 _rasterizer{
+    config::cols, config::fill_rows,
+    config::fill_div, config::fill_div,
+  };
+
+  vga::Band const _bands[3] {
+    { &_blue,       config::fill_top_margin,    &_bands[1] },
+    { &_rasterizer, config::fill_rows,          &_bands[2] },
+    { &_blue,       config::fill_bottom_margin, nullptr },
+  };
+
+  View _view;
+
+  ScreenVertex * _screen;
+  // Faces are sorted into buckets by depth, each a linked list threaded
+  // through _next, with the face's palette color alongside.
+  std::uint16_t _buckets[bucket_count];
+  std::uint16_t * _next;
+  std::uint8_t * _color;
+
+  void transform(float & near, float & far);
+  void sort_faces(float near, float far);
+  void draw_faces(vga::Pixel *);
+};
+
+}  // namespace rook
+}  // namespace demo
+
+#endif  // DEMO_ROOK_FILLED_H
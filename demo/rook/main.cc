@@ -1,7 +1,11 @@
+#include "demo/rook/chess.h"
+#include "demo/rook/filled.h"
 #include "demo/rook/rook.h"
 
 #include "demo/runner.h"
 
 int main() {
-  demo::run<demo::rook::Rook>();
+  demo::run<demo::rook::Rook,
+            demo::rook::FilledRook,
+            demo::rook::ChessSet>();
 }
@@ -0,0 +1,38 @@
+#include "demo/rook/mesh.h"
+
+namespace demo {
+namespace rook {
+
+// Reads an unsigned LEB128 varint, advancing 'p' past it.
+static unsigned read_varint(std::uint8_t const * & p) {
+  unsigned value = 0;
+  unsigned shift = 0;
+  std::uint8_t byte;
+  do {
+    byte = *p++;
+    value |= unsigned(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+void PackedMesh::decode_chains(std::uint16_t * lengths,
+                               std::uint16_t * path) const {
+  auto p = chains;
+  for (unsigned c = 0; c < chain_count; ++c) {
+    auto const length = read_varint(p);
+    lengths[c] = std::uint16_t(length);
+
+    auto v = read_varint(p);
+    *path++ = std::uint16_t(v);
+    for (unsigned i = 0; i < length; ++i) {
+      auto const z = read_varint(p);
+      // Undo the zigzag encoding.
+      v += (z & 1) ? ~(z >> 1) : (z >> 1);
+      *path++ = std::uint16_t(v);
+    }
+  }
+}
+
+}  // namespace rook
+}  // namespace demo
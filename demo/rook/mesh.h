@@ -0,0 +1,94 @@
+#ifndef DEMO_ROOK_MESH_H
+#define DEMO_ROOK_MESH_H
+
+#include <cstdint>
+
+#include "etl/math/vector.h"
+
+#include "math/geometry.h"
+
+namespace demo {
+namespace rook {
+
+/*
+ * A mesh's vertices and edges in compact form, as emitted by stlmunge.cc.
+ * This is meant to sit in Flash and be decoded into RAM when a scene starts.
+ *
+ * Each vertex is quantized to 10 bits per axis within the model's bounding
+ * box, and packed into a word as X | Y << 10 | Z << 20.  That's two-thirds
+ * the size of a Vec3h, with better precision for a model of moderate size.
+ *
+ * Edges are grouped into chains: polylines through the model, each sharing
+ * a vertex between consecutive edges, so that a renderer can reuse the last
+ * endpoint instead of fetching two vertices per edge.  The vertices are
+ * numbered in the order the chains first reach them.  Each chain is stored
+ * as a series of unsigned LEB128 varints (seven bits per byte, least
+ * significant first, high bit set on all but the last byte):
+ *  1. The number of edges in the chain.
+ *  2. The index of its first vertex.
+ *  3. For each edge, the change in vertex index along it, zigzag encoded
+ *     (0, -1, 1, -2, ... map to 0, 1, 2, 3, ...).
+ * Thanks to the numbering, most steps take a single byte.
+ *
+ * Alongside the chains are the outward normals of the two faces next to each
+ * edge, in the order the chains visit the edges, for culling.
+ *
+ * A model may come at several levels of detail, which share one vertex
+ * array: each level's vertices are a prefix of it, so vertex_count differs.
+ */
+struct PackedMesh {
+  static constexpr unsigned bits = 10;
+  static constexpr std::uint32_t mask = (1u << bits) - 1;
+
+  etl::math::Vec3f origin;  // Minimum corner of the bounding box.
+  etl::math::Vec3f step;    // Size of one quantization step on each axis.
+
+  unsigned vertex_count;
+  std::uint32_t const * vertices;
+
+  unsigned edge_count;
+  unsigned chain_count;
+  std::uint8_t const * chains;
+  math::Vec3h const (* edge_normals)[2];
+
+  etl::math::Vec3f vertex(unsigned i) const {
+    auto const v = vertices[i];
+    return {
+      origin.x + float(v & mask) * step.x,
+      origin.y + float((v >> bits) & mask) * step.y,
+      origin.z + float((v >> (2 * bits)) & mask) * step.z,
+    };
+  }
+
+  // Decodes the chains.  Each chain's edge count goes into 'lengths', which
+  // must have room for chain_count entries, and its vertices (one more than
+  // its edges) go into 'path', which must have room for edge_count +
+  // chain_count.
+  void decode_chains(std::uint16_t * lengths, std::uint16_t * path) const;
+};
+
+/*
+ * A model compiled from an STL file: its mesh at each level of detail, most
+ * detailed first, plus what the filled renderer needs.
+ */
+struct Model {
+  unsigned lod_count;
+  PackedMesh const * lods;
+
+  // Bounding sphere, for estimating size on screen.
+  etl::math::Vec3f bound_center;
+  float bound_radius;
+
+  // Faces, as indices into the full-detail vertices, wound counter-clockwise
+  // seen from outside, and their outward unit normals.
+  unsigned triangle_count;
+  std::uint16_t const (* triangles)[3];
+  math::Vec3h const * triangle_normals;
+
+  PackedMesh const & mesh() const { return lods[0]; }
+};
+
+}  // namespace rook
+}  // namespace demo
+
+#endif  // DEMO_ROOK_MESH_H
@@ -1,19 +1,24 @@
 #include "demo/rook/rook.h"
 
-#include "etl/assert.h"
+#include "etl/algorithm.h"
 #include "etl/math/affine_transform.h"
 
 #include "vga/arena.h"
 #include "vga/graphics_1.h"
+#include "vga/measurement.h"
 #include "vga/rasterizer.h"
 
 #include "demo/rook/model.h"
+#include "demo/rook/transform.h"
 #include "demo/input.h"
+#include "demo/line_1.h"
 #include "demo/runner.h"
 
 #include <cmath>
+#include <cstdint>
 
 using etl::math::Mat4f;
+using etl::math::Vec2f;
 using etl::math::Vec2i;
 using etl::math::Vec3f;
 using etl::math::Vec4f;
@@ -44,42 +49,235 @@ using Pixel = vga::Rasterizer::Pixel;
  * glDrawElements.
  */
 
-Wireframe::Wireframe()
-    : transformed_vertices(vga::arena_new_array<Vec2i>(vertex_count)) {
+WireMesh::WireMesh(Model const &m)
+    : model(m),
+      vertex_x(vga::arena_new_array<float>(padded(m.mesh().vertex_count))),
+      vertex_y(vga::arena_new_array<float>(padded(m.mesh().vertex_count))),
+      vertex_z(vga::arena_new_array<float>(padded(m.mesh().vertex_count))),
+      transformed_vertices(
+          vga::arena_new_array<Vec2i>(padded(m.mesh().vertex_count))) {
+  // Unpack the model once, up front, so that each frame reads it from RAM.
+  auto const & mesh = m.mesh();
+  for (unsigned i = 0; i < padded(mesh.vertex_count); ++i) {
+    auto const v = i < mesh.vertex_count ? mesh.vertex(i) : Vec3f{0, 0, 0};
+    vertex_x[i] = v.x;
+    vertex_y[i] = v.y;
+    vertex_z[i] = v.z;
+  }
+  for (unsigned i = 0; i < m.lod_count; ++i) {
+    auto const & level = m.lods[i];
+    chains[i] = {
+      vga::arena_new_array<std::uint16_t>(level.chain_count),
+      vga::arena_new_array<std::uint16_t>(level.edge_count
+                                          + level.chain_count),
+    };
+    level.decode_chains(chains[i].lengths, chains[i].path);
+  }
+}
+
+WireMesh::~WireMesh() {
+  vertex_x = vertex_y = vertex_z = nullptr;
+  transformed_vertices = nullptr;
+  for (auto & c : chains) c.lengths = c.path = nullptr;
+}
+
+Wireframe::Wireframe() {
   rasterizer.set_fg_color(0b111111);
   rasterizer.set_bg_color(0b010000);
 
-  // Switch to whichever page has bitband support.
-  if (!rasterizer.can_bg_use_bitband()) {
-    rasterizer.flip_now();
-    ETL_ASSERT(rasterizer.can_bg_use_bitband());
+  // Start from a blank slate; after this, we only clear what we draw.
+  rasterizer.make_bg_graphics().clear_all();
+  rasterizer.copy_bg_to_fg();
+}
+
+/*
+ * Erase and present, below, work on the extents of the lines rather than the
+ * whole bitmap.  We draw with our own line drawer rather than the bit-banded
+ * Graphics1, so either page will do, and we can flip pages rather than
+ * copying.  The lines cover only a fraction of the bitmap, so clearing just
+ * their bounding box saves a full pass over 40 KiB each frame.
+ */
+
+static constexpr unsigned words_per_row = config::cols / 32;
+
+/*
+ * Makes the last frame drawn visible.  The new background is the frame
+ * before that, whose lines erase() will remove.
+ */
+void Wireframe::present() {
+  rasterizer.flip_now();
+  auto const shown = bg_extent;
+  bg_extent = fg_extent;
+  fg_extent = shown;
+}
+
+/*
+ * Clears the lines from the background.
+ */
+__attribute__((section(".ramcode.erase")))
+void Wireframe::erase() {
+  auto const dst = static_cast<std::uint32_t *>(rasterizer.get_bg_buffer());
+
+  for (unsigned y = bg_extent.top; y < bg_extent.bottom; ++y) {
+    for (unsigned w = bg_extent.left; w < bg_extent.right; ++w) {
+      dst[y * words_per_row + w] = 0;
+    }
   }
+  bg_extent = {0, 0, 0, 0};
 }
 
-Wireframe::~Wireframe() {
-  transformed_vertices = nullptr;
+void Wireframe::cover(int min_x, int min_y, int max_x, int max_y) {
+  min_x = etl::max(min_x, 0);
+  min_y = etl::max(min_y, 0);
+  max_x = etl::min(max_x, int(config::cols) - 1);
+  max_y = etl::min(max_y, int(config::wireframe_rows) - 1);
+  if (min_x > max_x || min_y > max_y) return;
+
+  Extent const box {
+    unsigned(min_y), unsigned(max_y) + 1,
+    unsigned(min_x) / 32, unsigned(max_x) / 32 + 1,
+  };
+  if (bg_extent.top == bg_extent.bottom) {
+    bg_extent = box;
+  } else {
+    bg_extent = {
+      etl::min(bg_extent.top, box.top), etl::max(bg_extent.bottom, box.bottom),
+      etl::min(bg_extent.left, box.left), etl::max(bg_extent.right, box.right),
+    };
+  }
 }
 
-constexpr Vec4f expand(Vec3h const & v) {
-  return xf::augment(Vec3f{v});
+Bitmap1View Wireframe::view() {
+  return {
+    static_cast<std::uint32_t *>(rasterizer.get_bg_buffer()),
+    words_per_row,
+    config::wireframe_rows,
+  };
+}
+
+/*
+ * Picks a level of detail for the model's size on screen, which we estimate
+ * by projecting its bounding sphere: the center, and a point one radius
+ * away along each model axis, taking the farthest.  Lines beyond a few per
+ * pixel pile up into a blur, so we use the most detailed level that keeps
+ * within config::lod_edges_per_pixel, or failing that, the least.
+ */
+void WireMesh::select_lod(Mat4f const &m) {
+  auto const c = model.bound_center;
+  auto const r = model.bound_radius;
+  auto const project = [&m](float x, float y, float z) {
+    auto const v = m * Vec4f{x, y, z, 1};
+    return Vec2f{v.x / v.w, v.y / v.w};
+  };
+
+  auto const center = project(c.x, c.y, c.z);
+  Vec2f const rim[] {
+    project(c.x + r, c.y, c.z),
+    project(c.x, c.y + r, c.z),
+    project(c.x, c.y, c.z + r),
+  };
+
+  float radius_sq = 0;
+  for (auto const & p : rim) {
+    auto const dx = p.x - center.x, dy = p.y - center.y;
+    radius_sq = etl::max(radius_sq, dx * dx + dy * dy);
+  }
+
+  auto const budget = config::lod_edges_per_pixel * std::sqrt(radius_sq);
+  lod = model.lod_count - 1;
+  for (unsigned i = 0; i < model.lod_count; ++i) {
+    if (model.lods[i].edge_count <= budget) {
+      lod = i;
+      break;
+    }
+  }
 }
 
+/*
+ * Transforms and projects every vertex used by the current level of detail.
+ *
+ * Since we only need screen X and Y, we only need three rows of the matrix:
+ * those producing X, Y, and W.  We extract them up front (by transforming the
+ * basis vectors, which yields the columns) and then run a fused 3x4 multiply
+ * over the vertex arrays, followed by a single reciprocal and two multiplies
+ * in place of the two divides in the perspective projection.
+ *
+ * The loop body handles a block of vertices at a time, with no branches, to
+ * give the compiler room to overlap the divides with the multiply-adds of
+ * neighboring vertices.
+ */
 __attribute__((section(".ramcode.transform_vertices")))
-void Wireframe::transform_vertices(Mat4f const &m) const {
-  for (unsigned i = 0; i < vertex_count; ++i) {
-    Vec3f v = xf::project(m * expand(vertices[i]));
-    transformed_vertices[i] = { static_cast<int>(v.x),
-                                static_cast<int>(v.y) };
+void WireMesh::transform_vertices(Mat4f const &m) {
+  vga::msig_e_set(1);
+
+  auto const out = transformed_vertices;
+
+  // Each level's vertices are a prefix of the array, so coarser levels
+  // transform fewer.  Rounding up to a block stays within the padding.
+  auto const count = model.lods[lod].vertex_count;
+  transform_points(m, vertex_x, vertex_y, vertex_z, out, padded(count));
+
+  // Record the bounding box of the model, which contains every line we're
+  // about to draw.
+  min_x = max_x = out[0].x;
+  min_y = max_y = out[0].y;
+  for (unsigned i = 1; i < count; ++i) {
+    min_x = etl::min(min_x, out[i].x);
+    max_x = etl::max(max_x, out[i].x);
+    min_y = etl::min(min_y, out[i].y);
+    max_y = etl::max(max_y, out[i].y);
   }
+
+  vga::msig_e_clear(1);
 }
 
+/*
+ * Draws the edges of the current level of detail, moved by 'offset' pixels,
+ * skipping any edge whose adjacent faces both face away from 'eye' (given in
+ * model space).  Such edges are on the far side of the model, so this
+ * produces something close to hidden-line output, while drawing roughly half
+ * the lines.
+ *
+ * Edges come in chains, so each one after the first in a chain starts where
+ * the last one ended, and we carry its vertex over rather than fetching it
+ * again.
+ */
 __attribute__((section(".ramcode.draw_edges")))
-void Wireframe::draw_edges(vga::Graphics1 &g) {
-  for (unsigned i = 0; i < edge_count; ++i) {
-    Vec2i const &a = transformed_vertices[edges[i][0]];
-    Vec2i const &b = transformed_vertices[edges[i][1]];
-
-    g.set_line_unclipped(a.x, a.y, b.x, b.y);
+void WireMesh::draw_edges(Bitmap1View const &view,
+                          Vec3f const &eye,
+                          Vec2i const &offset) {
+  auto const & level = model.lods[lod];
+  auto const lengths = chains[lod].lengths;
+  auto path = chains[lod].path;
+  auto normals = level.edge_normals;
+
+  for (unsigned c = 0; c < level.chain_count; ++c) {
+    unsigned ai = *path++;
+    Vec2i a = transformed_vertices[ai];
+
+    for (unsigned i = lengths[c]; i > 0; --i, ++normals) {
+      unsigned const bi = *path++;
+      Vec2i const b = transformed_vertices[bi];
+
+      Vec3f const to_eye {
+        eye.x - vertex_x[ai],
+        eye.y - vertex_y[ai],
+        eye.z - vertex_z[ai],
+      };
+      auto const facing = [&to_eye](Vec3h const &n) {
+        return float(n.x) * to_eye.x
+             + float(n.y) * to_eye.y
+             + float(n.z) * to_eye.z > 0;
+      };
+      if (facing((*normals)[0]) || facing((*normals)[1])) {
+        set_line(view,
+                 a.x + offset.x, a.y + offset.y,
+                 b.x + offset.x, b.y + offset.y);
+      }
+
+      ai = bi;
+      a = b;
+    }
   }
 }
 
@@ -105,32 +303,79 @@ void BragLine::string(Pixel fore, Pixel back, char const *s) {
   }
 }
 
-void BragLine::show_msg(unsigned frame) {
-  auto pos_in_glyph = frame % 10;
-  auto pos_in_message = (frame / 10) % 81;
+/*******************************************************************************
+ * The main bits.
+ */
+
+View::View(float center_x, float center_y, float scale, float distance)
+  : projection(
+      xf::translate(Vec3f{center_x, center_y, 0})
+      * xf::scale(Vec3f{scale, scale, 1})
+      * xf::persp(-10, -10, 10, 10, 20, 100)),
+    orbit(Mat4f::identity()),
+    model(Mat4f::identity()),
+    view_inverse(Mat4f::identity()),
+    model_inverse(Mat4f::identity()),
+    home_distance(distance),
+    distance(distance),
+    target_distance(distance) {}
+
+void View::update(unsigned j, bool toggle_distance) {
+  if (j & JoyBits::up) {
+    model = model * xf::rotate_z(-0.01f);
+    model_inverse = xf::rotate_z(+0.01f) * model_inverse;
+  }
+  if (j & JoyBits::down) {
+    model = model * xf::rotate_z(+0.01f);
+    model_inverse = xf::rotate_z(-0.01f) * model_inverse;
+  }
 
-  text.set_x_adj(-pos_in_glyph);
+  if (j & JoyBits::left) {
+    orbit = orbit * xf::rotate_y(-0.01f);
+    view_inverse = xf::rotate_y(+0.01f) * view_inverse;
+  }
+  if (j & JoyBits::right) {
+    orbit = orbit * xf::rotate_y(+0.01f);
+    view_inverse = xf::rotate_y(-0.01f) * view_inverse;
+  }
 
-  text.clear_framebuffer(0b010000);
-  for (unsigned i = 0; i < 81 - pos_in_message; ++i) {
-    text.put_packed(i, 0, message[pos_in_message + i]);
+  if (toggle_distance) {
+    target_distance = target_distance == home_distance
+                    ? home_distance * config::zoom_out
+                    : home_distance;
   }
-  for (unsigned i = 0; i < pos_in_message; ++i) {
-    text.put_packed(81 - pos_in_message + i, 0, message[i]);
+  // Glide toward the target by a fixed ratio per frame, so the apparent
+  // size changes steadily.
+  if (distance < target_distance) {
+    distance = etl::min(distance * 1.02f, target_distance);
+  } else {
+    distance = etl::max(distance / 1.02f, target_distance);
   }
 }
 
-/*******************************************************************************
- * The main bits.
- */
+Mat4f View::transform() const {
+  return projection
+       * xf::translate(Vec3f{0, 0, -distance})
+       * orbit
+       * model;
+}
+
+Vec3f View::eye() const {
+  // The eye sits at the origin of view space, which is 'distance' along Z
+  // before the view rotations.
+  auto const e = model_inverse * view_inverse
+               * Vec4f{0, 0, distance, 1};
+  return { e.x, e.y, e.z };
+}
+
+Vec3f View::to_model(Vec3f const &direction) const {
+  auto const d = model_inverse * view_inverse
+               * Vec4f{direction.x, direction.y, direction.z, 0};
+  return { d.x, d.y, d.z };
+}
 
 Rook::Rook()
-  : _projection(
-      xf::translate(Vec3f{config::cols/2, config::wireframe_rows/2, 0})
-      * xf::scale(Vec3f{config::rows/2, config::rows/2, 1})
-      * xf::persp(-10, -10, 10, 10, 20, 100)
-      * xf::translate(Vec3f{0, 0, -70})),
-    _model(Mat4f::identity()) {}
+  : _view(config::cols/2, config::wireframe_rows/2, config::rows/2) {}
 
 void Rook::configure_band_list() {
   vga::configure_band_list(_bands);
@@ -139,25 +384,17 @@ void Rook::configure_band_list() {
 __attribute__((section(".ramcode.rook_run")))
 bool Rook::render_frame(unsigned frame) {
   auto const continuing = !user_button_pressed();
-  auto const j = read_joystick();
-  _wireframe.rasterizer.copy_bg_to_fg();
-
-  if (j & JoyBits::up) _model = _model * xf::rotate_z(-0.01f);
-  if (j & JoyBits::down) _model = _model * xf::rotate_z(+0.01f);
-
-  if (j & JoyBits::left) {
-    _projection = _projection * xf::rotate_y(-0.01f);
-  }
-  if (j & JoyBits::right) {
-    _projection = _projection * xf::rotate_y(+0.01f);
-  }
+  _wireframe.present();
+  _view.update(read_joystick(), center_button_pressed());
 
-  _brag_line.show_msg(frame % 810);
+  _brag_line.marquee.scroll_to(frame);
 
-  auto g = _wireframe.rasterizer.make_bg_graphics();
-  g.clear_all();
-  _wireframe.transform_vertices(_projection * _model);
-  _wireframe.draw_edges(g);
+  auto const m = _view.transform();
+  _wireframe.erase();
+  _mesh.select_lod(m);
+  _mesh.transform_vertices(m);
+  _wireframe.cover(_mesh.min_x, _mesh.min_y, _mesh.max_x, _mesh.max_y);
+  _mesh.draw_edges(_wireframe.view(), _view.eye(), Vec2i{0, 0});
 
   return continuing;
 }
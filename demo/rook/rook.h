@@ -10,23 +10,122 @@
 #include "vga/rast/text_10x16.h"
 #include "vga/font_10x16.h"
 
+#include "demo/line_1.h"
+#include "demo/marquee.h"
 #include "demo/scene.h"
 #include "demo/rook/config.h"
+#include "demo/rook/mesh.h"
+#include "demo/rook/model.h"
 
 namespace demo {
 namespace rook {
 
+/*
+ * Viewing state shared by the rook scenes.  The joystick spins the model and
+ * the camera; we track the inverses of those rotations as we go, to find the
+ * eye (and the light) in model space.  The center button moves the eye back
+ * and forth between two distances.
+ */
+struct View {
+  etl::math::Mat4f projection;
+  etl::math::Mat4f orbit;
+  etl::math::Mat4f model;
+  etl::math::Mat4f view_inverse;
+  etl::math::Mat4f model_inverse;
+  float home_distance;
+  float distance;
+  float target_distance;
+
+  // Builds a view that maps the model's origin to the given screen position,
+  // scaling by 'scale' pixels per unit of the perspective frustum, with the
+  // eye 'distance' away from it.
+  View(float center_x, float center_y, float scale,
+       float distance = config::eye_distance);
+
+  void update(unsigned joystick, bool toggle_distance);
+
+  etl::math::Mat4f transform() const;
+
+  // Position of the eye in model space.
+  etl::math::Vec3f eye() const;
+
+  // Converts a direction relative to the viewer into model space.
+  etl::math::Vec3f to_model(etl::math::Vec3f const &direction) const;
+};
+
+/*
+ * A model's edges and vertices, decoded into RAM, with room for the vertices
+ * once transformed.  The vertices are transformed once per frame; the edges
+ * can then be drawn any number of times, at different places on the screen.
+ */
+struct WireMesh {
+  Model const & model;
+
+  // Model vertices, split into one array per coordinate, padded to a
+  // multiple of the transform block size.
+  float * vertex_x;
+  float * vertex_y;
+  float * vertex_z;
+  etl::math::Vec2i * transformed_vertices;
+
+  // Edges at each level of detail, decoded from the packed mesh as chains:
+  // the number of edges in each, and the vertices along all of them, back to
+  // back.
+  struct Chains {
+    std::uint16_t * lengths;
+    std::uint16_t * path;
+  };
+  Chains chains[max_lod_count];
+
+  // Level of detail chosen for the current frame.
+  unsigned lod = 0;
+
+  // Bounds of the transformed vertices, in pixels, inclusive.
+  int min_x = 0, max_x = 0;
+  int min_y = 0, max_y = 0;
+
+  explicit WireMesh(Model const &);
+  ~WireMesh();
+
+  void select_lod(etl::math::Mat4f const &m);
+  void transform_vertices(etl::math::Mat4f const &m);
+  void draw_edges(Bitmap1View const &,
+                  etl::math::Vec3f const &eye,
+                  etl::math::Vec2i const &offset);
+};
+
+/*
+ * A page-flipped 1bpp bitmap for drawing wireframes into, which keeps track
+ * of where the lines are.
+ */
 struct Wireframe {
+  // Region of the bitmap that may contain lines, in 32-pixel words.  Rows
+  // and words are half-open ranges; an empty extent has top == bottom.
+  struct Extent {
+    unsigned top, bottom;
+    unsigned left, right;
+  };
+
   vga::rast::Bitmap_1 rasterizer{config::cols,
                                  config::wireframe_rows,
                                  config::top_margin};
-  etl::math::Vec2i * transformed_vertices;
+
+  // Where lines may be in each page.  We only clear these, rather than the
+  // whole bitmap.
+  Extent bg_extent{0, 0, 0, 0};
+  Extent fg_extent{0, 0, 0, 0};
 
   Wireframe();
-  ~Wireframe();
 
-  void transform_vertices(etl::math::Mat4f const &m) const;
-  void draw_edges(vga::Graphics1 &g);
+  void present();
+  void erase();
+
+  // Notes that lines may be drawn within the given box of pixels
+  // (inclusive), which may extend past the bitmap.
+  void cover(int min_x, int min_y, int max_x, int max_y);
+
+  // The background page, for drawing.
+  Bitmap1View view();
 };
 
 struct BragLine {
@@ -38,9 +137,9 @@ struct BragLine {
     config::text_rows,
     config::rows - config::text_rows,
     true};
+  Marquee marquee{text, 0, message, 81};
 
   BragLine();
-  void show_msg(unsigned frame);
 
 private:
   void string(vga::Rasterizer::Pixel fore,
@@ -59,6 +158,7 @@ public:
 private:
   vga::rast::SolidColor _blue{config::cols, 0b010000};
   Wireframe _wireframe;
+  WireMesh _mesh{rook_model};
   BragLine _brag_line;
 
   vga::Band const _bands[4] {
@@ -68,8 +168,7 @@ private:
     { &_brag_line.text,       config::text_rows,         nullptr },
   };
 
-  etl::math::Mat4f _projection;
-  etl::math::Mat4f _model;
+  View _view;
 };
 
 void legacy_run();
@@ -0,0 +1,1274 @@
+/*
+ * Host tool that compiles STL files into the models declared in model.h.
+ *
+ * Usage: stlmunge <output-dir> <file.stl>...
+ *
+ * Each file becomes a model named after it: rook.stl becomes rook_model.
+ * Files may be binary or ASCII STL.  The output is model.h and model.cc in
+ * the output directory; see demo/rook/mesh.h for the representation.
+ *
+ * For each model, we
+ *  1. Merge vertices that agree to within 1e-4, using a hash of their
+ *     rounded coordinates, and collect the unique edges and the faces next to
+ *     each.
+ *  2. Simplify the mesh into coarser levels of detail by edge collapse.
+ *  3. Link each level's edges into chains, and number the vertices in the
+ *     order the chains reach them.
+ *  4. Quantize and pack the vertices and chains.
+ *
+ * This is built and run on the host by site_cobble/compile_stl.py.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Vertices closer than 1/merge_scale on every axis are merged.
+static constexpr double merge_scale = 10000;
+
+// The source models sit above the origin; this moves them down so that it's
+// near their middle.
+static constexpr double z_offset = -20;
+
+// Simplified levels of detail, as fractions of the full vertex count.
+static constexpr double lod_fractions[] {0.4, 0.15};
+
+// Vertices are packed with this many bits per axis.
+static constexpr unsigned quant_bits = 10;
+static constexpr unsigned quant_max = (1u << quant_bits) - 1;
+
+[[noreturn]] static void fail(char const * fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  std::vfprintf(stderr, fmt, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+  std::exit(1);
+}
+
+
+/*******************************************************************************
+ * Geometry
+ */
+
+struct Vec3 {
+  double x, y, z;
+};
+
+static Vec3 operator-(Vec3 const & a, Vec3 const & b) {
+  return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+static double dot(Vec3 const & a, Vec3 const & b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vec3 cross(Vec3 const & u, Vec3 const & v) {
+  return {u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x};
+}
+
+/*
+ * Adds three numbers with Kahan-Babuska compensation, which gets the squared
+ * lengths below correctly rounded in more cases than plain addition.
+ */
+static double compensated_sum(double a, double b, double c) {
+  double sum = 0, error = 0;
+  for (auto x : {a, b, c}) {
+    auto const t = sum + x;
+    error += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+    sum = t;
+  }
+  return sum + error;
+}
+
+/*
+ * Computes the unit normal of a triangle from its winding (counter-clockwise
+ * seen from outside), rather than trusting the normal stored in the STL.
+ * Returns false for degenerate triangles.
+ */
+static bool face_normal(Vec3 const & p0, Vec3 const & p1, Vec3 const & p2,
+                        Vec3 & normal) {
+  auto const n = cross(p1 - p0, p2 - p0);
+  auto const len = std::sqrt(compensated_sum(n.x * n.x, n.y * n.y, n.z * n.z));
+  if (len < 1e-9) return false;
+  normal = {n.x / len, n.y / len, n.z / len};
+  return true;
+}
+
+
+/*******************************************************************************
+ * Input
+ */
+
+struct Facet {
+  Vec3 v[3];
+};
+
+/*
+ * Read-only view of a whole file, memory-mapped.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(char const * path) {
+    auto const fd = open(path, O_RDONLY);
+    if (fd < 0) fail("can't open %s", path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) fail("can't stat %s", path);
+    _size = size_t(st.st_size);
+    if (_size) {
+      auto const p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) fail("can't map %s", path);
+      _data = static_cast<char const *>(p);
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (_data) munmap(const_cast<char *>(_data), _size);
+  }
+
+  MappedFile(MappedFile const &) = delete;
+  MappedFile & operator=(MappedFile const &) = delete;
+
+  char const * data() const { return _data; }
+  size_t size() const { return _size; }
+
+private:
+  char const * _data = nullptr;
+  size_t _size = 0;
+};
+
+static float read_float(char const * p) {
+  float f;
+  std::memcpy(&f, p, sizeof(f));  // Records leave half of these unaligned.
+  return f;
+}
+
+static std::uint32_t read_u32(char const * p) {
+  std::uint32_t n;
+  std::memcpy(&n, p, sizeof(n));
+  return n;
+}
+
+/*
+ * Reads binary STL: an 80-byte header, a triangle count, and a 50-byte record
+ * per triangle (normal, three vertices, attribute word).  We ignore the
+ * stored normal.
+ */
+static std::vector<Facet> read_binary(MappedFile const & file) {
+  auto const count = read_u32(file.data() + 80);
+  std::vector<Facet> facets(count);
+  auto p = file.data() + 84;
+  for (auto & f : facets) {
+    for (unsigned i = 0; i < 3; ++i) {
+      auto const v = p + 12 + 12 * i;
+      f.v[i] = {
+        read_float(v),
+        read_float(v + 4),
+        double(read_float(v + 8)) + z_offset,
+      };
+    }
+    p += 50;
+  }
+  return facets;
+}
+
+/*
+ * Reads ASCII STL, which looks like
+ *
+ *   solid name
+ *     facet normal nx ny nz
+ *       outer loop
+ *         vertex x y z
+ *         vertex x y z
+ *         vertex x y z
+ *       endloop
+ *     endfacet
+ *     ...
+ *   endsolid name
+ *
+ * We only need the vertices, and every three of them make a facet.  Numbers
+ * are read as single precision, like the binary format's.
+ */
+/*
+ * Reads a number starting at or after 'p', which mustn't reach 'end', and
+ * moves 'p' past it.  strtof wants a terminated string, which the mapping
+ * doesn't promise, so the number is copied out first.
+ */
+static bool read_number(char const * & p, char const * end, float & out) {
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+  char buf[64];
+  size_t n = 0;
+  while (p + n < end && n + 1 < sizeof(buf)
+         && p[n] && std::strchr("+-.0123456789eE", p[n])) {
+    buf[n] = p[n];
+    ++n;
+  }
+  buf[n] = 0;
+  char * stop;
+  out = std::strtof(buf, &stop);
+  if (stop == buf) return false;
+  p += stop - buf;
+  return true;
+}
+
+static std::vector<Facet> read_ascii(MappedFile const & file,
+                                     char const * path) {
+  std::vector<Facet> facets;
+  std::vector<Vec3> vertices;
+
+  // Vertices are lines whose first token is "vertex".  Matching the keyword
+  // only there keeps names on the solid and endsolid lines from being taken
+  // for vertices.
+  auto const end = file.data() + file.size();
+  for (auto p = file.data(); p < end; ) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    if (end - p > 6 && std::memcmp(p, "vertex", 6) == 0
+        && std::isspace(static_cast<unsigned char>(p[6]))) {
+      p += 6;
+      float c[3];
+      for (auto & x : c) {
+        if (!read_number(p, end, x)) fail("%s: bad vertex", path);
+      }
+      vertices.push_back({c[0], c[1], double(c[2]) + z_offset});
+    }
+    p = static_cast<char const *>(std::memchr(p, '\n', size_t(end - p)));
+    if (!p) break;
+    ++p;
+  }
+
+  if (vertices.size() % 3) fail("%s: vertex count isn't a multiple of 3", path);
+  for (size_t i = 0; i < vertices.size(); i += 3) {
+    facets.push_back({{vertices[i], vertices[i + 1], vertices[i + 2]}});
+  }
+  return facets;
+}
+
+static std::vector<Facet> read_stl(char const * path) {
+  MappedFile const file(path);
+  // ASCII files start with "solid", but so do some binary ones, so trust the
+  // binary format if the size matches its triangle count.
+  if (file.size() >= 84
+      && file.size() == 84 + 50 * size_t(read_u32(file.data() + 80))) {
+    return read_binary(file);
+  }
+  if (file.size() >= 5 && std::memcmp(file.data(), "solid", 5) == 0) {
+    return read_ascii(file, path);
+  }
+  fail("%s: not an STL file", path);
+}
+
+
+/*******************************************************************************
+ * Vertex merging and edge extraction
+ */
+
+struct GridKey {
+  long long x, y, z;
+
+  bool operator==(GridKey const & o) const {
+    return x == o.x && y == o.y && z == o.z;
+  }
+};
+
+struct GridKeyHash {
+  size_t operator()(GridKey const & k) const {
+    auto h = std::uint64_t(k.x) * 0x9E3779B97F4A7C15u;
+    h ^= std::uint64_t(k.y) * 0xC2B2AE3D27D4EB4Fu + (h << 6) + (h >> 2);
+    h ^= std::uint64_t(k.z) * 0x165667B19E3779F9u + (h << 6) + (h >> 2);
+    return size_t(h);
+  }
+};
+
+static GridKey grid_key(Vec3 const & p) {
+  return {
+    std::llround(p.x * merge_scale),
+    std::llround(p.y * merge_scale),
+    std::llround(p.z * merge_scale),
+  };
+}
+
+// An edge between two vertices, by index, with a < b.
+struct Edge {
+  unsigned a, b;
+
+  Edge(unsigned p, unsigned q) : a(std::min(p, q)), b(std::max(p, q)) {}
+
+  bool operator==(Edge const & o) const { return a == o.a && b == o.b; }
+};
+
+struct EdgeHash {
+  size_t operator()(Edge const & e) const {
+    return size_t(std::uint64_t(e.a) << 32 | e.b);
+  }
+};
+
+/*
+ * A set of edges, in the order they were first added, with the normals of
+ * the faces next to each.
+ */
+struct EdgeSet {
+  std::vector<Edge> edges;
+  std::vector<std::vector<Vec3>> normals;
+  std::unordered_map<Edge, unsigned, EdgeHash> ids;
+
+  // Adds an edge if it's new, returning its id and whether it was new.
+  unsigned add(Edge const & e, bool & added) {
+    auto const it = ids.find(e);
+    added = it == ids.end();
+    if (!added) return it->second;
+    auto const id = unsigned(edges.size());
+    ids.emplace(e, id);
+    edges.push_back(e);
+    normals.emplace_back();
+    return id;
+  }
+
+  size_t size() const { return edges.size(); }
+};
+
+struct Triangle {
+  unsigned v[3];
+  Vec3 normal;
+};
+
+// Finds the edges of a set of triangles, with the normals of the faces next
+// to each.
+static EdgeSet triangle_edges(std::vector<Triangle> const & triangles) {
+  EdgeSet set;
+  for (auto const & t : triangles) {
+    for (unsigned k = 0; k < 3; ++k) {
+      bool added;
+      auto const id = set.add(Edge(t.v[k], t.v[(k + 1) % 3]), added);
+      set.normals[id].push_back(t.normal);
+    }
+  }
+  return set;
+}
+
+
+/*******************************************************************************
+ * Decimation
+ *
+ * Quadric error metrics (Garland and Heckbert): the sum of squared distances
+ * from a point to a set of planes is a quadratic form, which we keep as the
+ * ten distinct coefficients of a symmetric 4x4 matrix.
+ */
+
+struct Quadric {
+  double q[10];
+};
+
+static Quadric plane_quadric(Vec3 const & p, Vec3 const & n, double weight) {
+  auto const a = n.x, b = n.y, c = n.z;
+  auto const d = -(a * p.x + b * p.y + c * p.z);
+  Quadric const unweighted {{
+    a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d,
+  }};
+  Quadric result;
+  for (unsigned i = 0; i < 10; ++i) result.q[i] = unweighted.q[i] * weight;
+  return result;
+}
+
+static Quadric operator+(Quadric const & a, Quadric const & b) {
+  Quadric result;
+  for (unsigned i = 0; i < 10; ++i) result.q[i] = a.q[i] + b.q[i];
+  return result;
+}
+
+static double quadric_error(Quadric const & m, Vec3 const & p) {
+  auto const & q = m.q;
+  auto const x = p.x, y = p.y, z = p.z;
+  return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+       + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+       + q[7] * z * z + 2 * q[8] * z + q[9];
+}
+
+// Merging u into v, which is u's rank'th cheapest collapse.
+struct Collapse {
+  double cost;
+  unsigned u, v;
+  unsigned rank;
+};
+
+/*
+ * A binary min-heap of collapses, by cost, with at most one for each vertex
+ * u, so that a vertex's collapse can be replaced or removed in place.  (Not
+ * std::priority_queue, which can do neither, and whose ties would come out
+ * in an unspecified order.)
+ */
+class CollapseHeap {
+public:
+  explicit CollapseHeap(size_t vertex_count) : _slot(vertex_count, none) {}
+
+  bool empty() const { return _items.empty(); }
+
+  // Queues c, replacing any collapse already queued for c.u.
+  void put(Collapse const & c) {
+    auto i = _slot[c.u];
+    if (i == none) {
+      i = _items.size();
+      _items.push_back(c);
+    } else {
+      _items[i] = c;
+    }
+    sift(i);
+  }
+
+  // Drops any collapse queued for u.
+  void remove(unsigned u) {
+    auto const i = _slot[u];
+    if (i == none) return;
+    _slot[u] = none;
+    auto const last = _items.back();
+    _items.pop_back();
+    if (i < _items.size()) {
+      _items[i] = last;
+      sift(i);
+    }
+  }
+
+  Collapse pop() {
+    auto const top = _items[0];
+    remove(top.u);
+    return top;
+  }
+
+private:
+  static constexpr size_t none = ~size_t(0);
+
+  std::vector<Collapse> _items;
+  std::vector<size_t> _slot;  // Index in _items of each vertex's collapse.
+
+  // Moves the item at i up or down to where it belongs.
+  void sift(size_t i) {
+    auto const c = _items[i];
+    while (i > 0) {
+      auto const parent = (i - 1) / 2;
+      if (_items[parent].cost <= c.cost) break;
+      place(i, _items[parent]);
+      i = parent;
+    }
+    for (;;) {
+      auto const l = 2 * i + 1, r = 2 * i + 2;
+      if (l >= _items.size()) break;
+      auto const m = r < _items.size() && _items[r].cost < _items[l].cost
+                   ? r : l;
+      if (_items[m].cost >= c.cost) break;
+      place(i, _items[m]);
+      i = m;
+    }
+    place(i, c);
+  }
+
+  void place(size_t i, Collapse const & c) {
+    _items[i] = c;
+    _slot[c.u] = i;
+  }
+};
+
+static bool contains(unsigned const (&t)[3], unsigned v) {
+  return t[0] == v || t[1] == v || t[2] == v;
+}
+
+/*
+ * Simplifies a mesh by half-edge collapse: repeatedly merging the vertex u
+ * into a neighbor v, which stays put, picking the collapse that adds the
+ * least quadric error.  Since vertices only disappear, every level uses a
+ * subset of the full mesh's vertices.  Vertices on edges without exactly two
+ * faces are left alone, to keep the outline of any holes, and collapses that
+ * would fold a face over or pinch the surface are skipped.
+ *
+ * The heap holds one collapse per vertex: its cheapest that hasn't been
+ * skipped.  A collapse changes the costs and neighborhoods of the surviving
+ * vertex and its neighbors, so their entries are replaced in place.
+ * (Queueing every directed edge instead, and re-queueing both directions of
+ * every edge around the survivor, filled the heap with stale entries, and
+ * popping them took most of the run time on large meshes.)
+ *
+ * Returns, for each fraction, the triangles that are left once the vertex
+ * count has dropped to that fraction.
+ */
+class Decimator {
+public:
+  Decimator(std::vector<Vec3> const & positions,
+            std::vector<Triangle> const & triangles)
+      : _positions(positions),
+        _alive_tri(triangles.size(), true),
+        _vertex_tris(positions.size()),
+        _quadrics(positions.size(), Quadric{{}}),
+        _locked(positions.size(), false),
+        _alive(positions.size()),
+        _heap(positions.size()) {
+    std::unordered_map<Edge, unsigned, EdgeHash> face_counts;
+
+    for (unsigned id = 0; id < triangles.size(); ++id) {
+      Tri t;
+      std::copy(triangles[id].v, triangles[id].v + 3, t.v);
+      _tris.push_back(t);
+      for (auto v : t.v) _vertex_tris[v].push_back(id);
+
+      auto const & p0 = positions[t.v[0]];
+      auto const & p1 = positions[t.v[1]];
+      auto const & p2 = positions[t.v[2]];
+      Vec3 n;
+      if (face_normal(p0, p1, p2, n)) {
+        auto const c = cross(p1 - p0, p2 - p0);
+        auto const area = std::sqrt(c.x * c.x + c.y * c.y + c.z * c.z) / 2;
+        auto const q = plane_quadric(p0, n, area);
+        for (auto v : t.v) _quadrics[v] = _quadrics[v] + q;
+      }
+      for (unsigned k = 0; k < 3; ++k) {
+        ++face_counts[Edge(t.v[k], t.v[(k + 1) % 3])];
+      }
+    }
+
+    for (auto const & fc : face_counts) {
+      if (fc.second != 2) _locked[fc.first.a] = _locked[fc.first.b] = true;
+    }
+
+    for (unsigned v = 0; v < positions.size(); ++v) {
+      _alive[v] = !_vertex_tris[v].empty();
+      if (_alive[v]) ++_live_count;
+    }
+
+    for (unsigned u = 0; u < positions.size(); ++u) {
+      if (_alive[u]) consider(u, 0);
+    }
+  }
+
+  std::vector<Triangle> simplify(double fraction) {
+    auto const target = size_t(std::llround(fraction * _positions.size()));
+    while (_live_count > target && !_heap.empty()) {
+      auto const c = _heap.pop();
+      if (collapsible(c.u, c.v)) {
+        collapse(c.u, c.v);
+      } else {
+        consider(c.u, c.rank + 1);
+      }
+    }
+
+    std::vector<Triangle> result;
+    for (unsigned id = 0; id < _tris.size(); ++id) {
+      if (!_alive_tri[id]) continue;
+      Triangle t {{}, {0, 0, 0}};
+      std::copy(_tris[id].v, _tris[id].v + 3, t.v);
+      face_normal(_positions[t.v[0]], _positions[t.v[1]], _positions[t.v[2]],
+                  t.normal);
+      result.push_back(t);
+    }
+    return result;
+  }
+
+private:
+  struct Tri {
+    unsigned v[3];
+  };
+
+  std::vector<Vec3> const & _positions;
+  std::vector<Tri> _tris;
+  std::vector<bool> _alive_tri;
+  std::vector<std::vector<unsigned>> _vertex_tris;
+  std::vector<Quadric> _quadrics;
+  std::vector<bool> _locked;
+  std::vector<bool> _alive;
+  size_t _live_count = 0;
+  CollapseHeap _heap;
+
+  struct Option {
+    double cost;
+    unsigned v;
+    unsigned order;  // Position in neighbors(), to break ties.
+  };
+  std::vector<Option> _options;
+
+  // Vertices sharing a face with v, in the order its faces reach them.
+  std::vector<unsigned> neighbors(unsigned v) const {
+    std::vector<unsigned> result;
+    result.reserve(_vertex_tris[v].size() + 1);
+    for (auto id : _vertex_tris[v]) {
+      for (auto w : _tris[id].v) {
+        if (w != v && std::find(result.begin(), result.end(), w)
+                      == result.end()) {
+          result.push_back(w);
+        }
+      }
+    }
+    return result;
+  }
+
+  // Queues u's rank'th cheapest collapse, if it has that many.  Ties go in
+  // the order neighbors() gives, to keep the output stable.
+  void consider(unsigned u, unsigned rank) {
+    if (_locked[u]) return;
+
+    // This runs several times per collapse, so it reuses its buffers, and
+    // only puts the one option it needs in order.
+    auto & options = _options;
+    options.clear();
+    for (auto v : neighbors(u)) {
+      auto const q = _quadrics[u] + _quadrics[v];
+      options.push_back({quadric_error(q, _positions[v]), v,
+                         unsigned(options.size())});
+    }
+    if (rank >= options.size()) {
+      _heap.remove(u);
+      return;
+    }
+    std::nth_element(options.begin(), options.begin() + rank, options.end(),
+                     [](Option const & a, Option const & b) {
+                       return a.cost < b.cost
+                           || (a.cost == b.cost && a.order < b.order);
+                     });
+    _heap.put({options[rank].cost, u, options[rank].v, rank});
+  }
+
+  // Checks that merging u into v keeps the surface a manifold (the only
+  // vertices next to both are those opposite the edge) and doesn't turn any
+  // face over.
+  bool collapsible(unsigned u, unsigned v) const {
+    std::vector<unsigned> shared, opposite;
+    for (auto id : _vertex_tris[u]) {
+      if (!contains(_tris[id].v, v)) continue;
+      shared.push_back(id);
+      for (auto w : _tris[id].v) {
+        if (w != u && w != v) opposite.push_back(w);
+      }
+    }
+    if (shared.empty()) return false;
+
+    auto nu = neighbors(u), nv = neighbors(v);
+    std::sort(nu.begin(), nu.end());
+    std::sort(nv.begin(), nv.end());
+    std::vector<unsigned> common;
+    std::set_intersection(nu.begin(), nu.end(), nv.begin(), nv.end(),
+                          std::back_inserter(common));
+    std::sort(opposite.begin(), opposite.end());
+    opposite.erase(std::unique(opposite.begin(), opposite.end()),
+                   opposite.end());
+    if (common != opposite) return false;
+
+    for (auto id : _vertex_tris[u]) {
+      if (contains(_tris[id].v, v)) continue;
+      Vec3 before[3], after[3];
+      for (unsigned k = 0; k < 3; ++k) {
+        auto const w = _tris[id].v[k];
+        before[k] = _positions[w];
+        after[k] = _positions[w == u ? v : w];
+      }
+      Vec3 n0, n1;
+      if (!face_normal(before[0], before[1], before[2], n0)
+          || !face_normal(after[0], after[1], after[2], n1)
+          || dot(n0, n1) <= 0.2) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void collapse(unsigned u, unsigned v) {
+    for (auto id : _vertex_tris[u]) {
+      auto & t = _tris[id].v;
+      if (contains(t, v)) {
+        _alive_tri[id] = false;
+        for (auto w : t) {
+          if (w == u) continue;
+          auto & list = _vertex_tris[w];
+          list.erase(std::remove(list.begin(), list.end(), id), list.end());
+        }
+      } else {
+        *std::find(t, t + 3, u) = v;
+        _vertex_tris[v].push_back(id);
+      }
+    }
+    _vertex_tris[u].clear();
+    _alive[u] = false;
+    _heap.remove(u);
+    --_live_count;
+    _quadrics[v] = _quadrics[u] + _quadrics[v];
+
+    // v's quadric has changed, and so has the cost of collapsing it or any
+    // of its neighbors, whose neighborhoods may have changed too.
+    consider(v, 0);
+    for (auto w : neighbors(v)) consider(w, 0);
+  }
+};
+
+
+/*******************************************************************************
+ * Chaining
+ */
+
+struct Chain {
+  std::vector<unsigned> vertices;
+  std::vector<unsigned> edges;  // Ids in the EdgeSet.
+};
+
+/*
+ * Decomposes an edge graph into as few chains (polylines) as we can, so that
+ * the renderer can walk each one, reusing the previous endpoint.  Every
+ * vertex of odd degree has to end a chain, so we pair those up with virtual
+ * edges, making every degree even.  An Euler circuit of the result (found
+ * with Hierholzer's algorithm), split at the virtual edges, gives the chains.
+ */
+static std::vector<Chain> chain_edges(unsigned vertex_total,
+                                      std::vector<Edge> const & edges) {
+  struct Link {
+    unsigned to, id;
+  };
+  auto const real_edge_count = unsigned(edges.size());
+
+  std::vector<std::vector<Link>> adjacency(vertex_total);
+  for (unsigned id = 0; id < real_edge_count; ++id) {
+    adjacency[edges[id].a].push_back({edges[id].b, id});
+    adjacency[edges[id].b].push_back({edges[id].a, id});
+  }
+
+  auto virtual_id = real_edge_count;
+  unsigned pending = ~0u;
+  for (unsigned v = 0; v < vertex_total; ++v) {
+    if (adjacency[v].size() % 2 == 0) continue;
+    if (pending == ~0u) {
+      pending = v;
+    } else {
+      adjacency[pending].push_back({v, virtual_id});
+      adjacency[v].push_back({pending, virtual_id});
+      ++virtual_id;
+      pending = ~0u;
+    }
+  }
+
+  std::vector<bool> used(virtual_id, false);
+  std::vector<size_t> cursor(vertex_total, 0);
+  std::vector<Chain> chains;
+
+  struct Step {
+    unsigned vertex, id;
+  };
+  std::vector<Step> stack, circuit;
+
+  for (unsigned start = 0; start < vertex_total; ++start) {
+    stack.assign(1, {start, ~0u});
+    circuit.clear();
+    while (!stack.empty()) {
+      auto const v = stack.back().vertex;
+      auto const & adj = adjacency[v];
+      while (cursor[v] < adj.size() && used[adj[cursor[v]].id]) ++cursor[v];
+      if (cursor[v] < adj.size()) {
+        auto const & link = adj[cursor[v]];
+        used[link.id] = true;
+        stack.push_back({link.to, link.id});
+      } else {
+        circuit.push_back(stack.back());
+        stack.pop_back();
+      }
+    }
+    std::reverse(circuit.begin(), circuit.end());
+    if (circuit.size() < 2) continue;
+
+    // Steps of the circuit, each arriving at circuit[i] from circuit[i - 1].
+    // Start just after the last virtual edge, if there is one, so that no
+    // chain wraps around the end.
+    auto const step_count = circuit.size() - 1;
+    size_t first = 0;
+    for (size_t i = step_count; i-- > 0;) {
+      if (circuit[i + 1].id >= real_edge_count) {
+        first = (i + 1) % step_count;
+        break;
+      }
+    }
+
+    Chain * current = nullptr;
+    for (size_t k = 0; k < step_count; ++k) {
+      auto const i = (first + k) % step_count;
+      auto const from = circuit[i].vertex;
+      auto const & to = circuit[i + 1];
+      if (to.id >= real_edge_count) {
+        current = nullptr;
+        continue;
+      }
+      if (!current) {
+        chains.emplace_back();
+        current = &chains.back();
+        current->vertices.push_back(from);
+      }
+      current->vertices.push_back(to.vertex);
+      current->edges.push_back(to.id);
+    }
+  }
+  return chains;
+}
+
+
+/*******************************************************************************
+ * Packing
+ */
+
+static void put_varint(std::vector<std::uint8_t> & out, unsigned n) {
+  while (n >= 0x80) {
+    out.push_back(std::uint8_t((n & 0x7F) | 0x80));
+    n >>= 7;
+  }
+  out.push_back(std::uint8_t(n));
+}
+
+static unsigned zigzag(int n) {
+  return n >= 0 ? unsigned(n) * 2 : unsigned(-n) * 2 - 1;
+}
+
+struct Level {
+  EdgeSet edges;
+  std::vector<Chain> chains;
+  unsigned vertex_count;
+  std::vector<std::uint8_t> packed_chains;
+};
+
+struct Model {
+  std::string name;
+  unsigned vertex_count;
+  std::vector<Level> levels;
+  std::vector<std::uint32_t> packed_vertices;
+  Vec3 box_min, quant_step, bound_center;
+  double bound_radius;
+  std::vector<Triangle> triangles;
+};
+
+static double axis(Vec3 const & v, unsigned i) {
+  return i == 0 ? v.x : i == 1 ? v.y : v.z;
+}
+
+static double & axis(Vec3 & v, unsigned i) {
+  return i == 0 ? v.x : i == 1 ? v.y : v.z;
+}
+
+static Model compile(std::string const & name,
+                     std::vector<Facet> const & facets) {
+  std::fprintf(stderr, "%zu triangles in %s\n", facets.size(), name.c_str());
+
+  Model model;
+  model.name = name;
+
+  std::unordered_map<GridKey, unsigned, GridKeyHash> point_ids;
+  std::vector<Vec3> positions;
+  EdgeSet unique_edges;
+  unsigned trivial_edges = 0, duplicate_edges = 0;
+
+  for (auto const & f : facets) {
+    unsigned indices[3];
+    for (unsigned k = 0; k < 3; ++k) {
+      auto const r = point_ids.emplace(grid_key(f.v[k]),
+                                       unsigned(positions.size()));
+      if (r.second) positions.push_back(f.v[k]);
+      indices[k] = r.first->second;
+    }
+
+    Vec3 normal;
+    auto const has_normal = face_normal(f.v[0], f.v[1], f.v[2], normal);
+
+    // Keep the faces too, for filled rendering, minus any that have
+    // collapsed.
+    if (has_normal && indices[0] != indices[1] && indices[1] != indices[2]
+        && indices[2] != indices[0]) {
+      model.triangles.push_back({{indices[0], indices[1], indices[2]},
+                                 normal});
+    }
+
+    for (unsigned k = 0; k < 3; ++k) {
+      auto const a = indices[k], b = indices[(k + 1) % 3];
+      if (a == b) {
+        ++trivial_edges;
+        continue;
+      }
+      bool added;
+      auto const id = unique_edges.add(Edge(a, b), added);
+      if (!added) ++duplicate_edges;
+      if (has_normal) unique_edges.normals[id].push_back(normal);
+    }
+  }
+
+  auto const vertex_count = unsigned(positions.size());
+  if (vertex_count > 0xFFFF) fail("%s: too many vertices", name.c_str());
+  model.vertex_count = vertex_count;
+
+  std::fprintf(stderr, "%u unique points.\n", vertex_count);
+  std::fprintf(stderr, "%zu unique edges.\n", unique_edges.size());
+  std::fprintf(stderr, "%u edges rejected as trivial.\n", trivial_edges);
+  std::fprintf(stderr, "%u edges rejected as duplicate.\n", duplicate_edges);
+  std::fprintf(stderr, "%zu non-degenerate triangles kept.\n",
+               model.triangles.size());
+
+  // Level zero is the full mesh, with every edge we found (including a few
+  // that only border degenerate faces); the rest come from decimation.
+  model.levels.emplace_back();
+  model.levels[0].edges = std::move(unique_edges);
+  {
+    Decimator decimator(positions, model.triangles);
+    for (auto fraction : lod_fractions) {
+      model.levels.emplace_back();
+      model.levels.back().edges =
+          triangle_edges(decimator.simplify(fraction));
+    }
+  }
+
+  for (size_t i = 0; i < model.levels.size(); ++i) {
+    auto & level = model.levels[i];
+    level.chains = chain_edges(vertex_count, level.edges.edges);
+    std::fprintf(stderr,
+                 "LOD %zu: %zu edges in %zu chains, drawing reads %zu "
+                 "vertices (down from %zu).\n",
+                 i, level.edges.size(), level.chains.size(),
+                 level.edges.size() + level.chains.size(),
+                 2 * level.edges.size());
+  }
+
+  // Renumber the vertices in the order the chains visit them, coarsest level
+  // first.  Each level's vertices are then a prefix of the next level's, so a
+  // coarse level only transforms the start of the vertex array, and within a
+  // level the renderer's vertex reads are close to sequential.
+  std::vector<unsigned> new_index(vertex_count, ~0u);
+  unsigned next_index = 0;
+  for (size_t i = model.levels.size(); i-- > 0;) {
+    auto & level = model.levels[i];
+    for (auto const & c : level.chains) {
+      for (auto v : c.vertices) {
+        if (new_index[v] == ~0u) new_index[v] = next_index++;
+      }
+    }
+    level.vertex_count = next_index;
+  }
+  for (auto & n : new_index) {
+    if (n == ~0u) n = next_index++;
+  }
+  model.levels[0].vertex_count = vertex_count;
+
+  for (size_t i = 0; i < model.levels.size(); ++i) {
+    for (auto const & c : model.levels[i].chains) {
+      for (auto v : c.vertices) {
+        if (new_index[v] >= model.levels[i].vertex_count) {
+          fail("LOD %zu uses vertices outside its prefix", i);
+        }
+      }
+    }
+  }
+
+  std::vector<Vec3> ordered(vertex_count);
+  for (unsigned v = 0; v < vertex_count; ++v) {
+    ordered[new_index[v]] = positions[v];
+  }
+  for (auto & t : model.triangles) {
+    for (auto & v : t.v) v = new_index[v];
+  }
+
+  // Bounding sphere, for choosing a level of detail: centered on the
+  // bounding box, and just big enough.
+  Vec3 box_max;
+  model.box_min = box_max = ordered[0];
+  for (auto const & p : ordered) {
+    for (unsigned i = 0; i < 3; ++i) {
+      axis(model.box_min, i) = std::min(axis(model.box_min, i), axis(p, i));
+      axis(box_max, i) = std::max(axis(box_max, i), axis(p, i));
+    }
+  }
+  for (unsigned i = 0; i < 3; ++i) {
+    auto const lo = axis(model.box_min, i), hi = axis(box_max, i);
+    axis(model.bound_center, i) = (lo + hi) / 2;
+    axis(model.quant_step, i) = hi > lo ? (hi - lo) / quant_max : 1.0;
+  }
+  model.bound_radius = 0;
+  for (auto const & p : ordered) {
+    auto const d = p - model.bound_center;
+    model.bound_radius = std::max(model.bound_radius,
+        std::sqrt(compensated_sum(d.x * d.x, d.y * d.y, d.z * d.z)));
+  }
+
+  // Pack the vertices and chains; see demo/rook/mesh.h for the format.
+  for (auto const & p : ordered) {
+    std::uint32_t packed = 0;
+    for (unsigned i = 0; i < 3; ++i) {
+      auto const q = std::llround((axis(p, i) - axis(model.box_min, i))
+                                  / axis(model.quant_step, i));
+      packed |= std::uint32_t(q) << (quant_bits * i);
+    }
+    model.packed_vertices.push_back(packed);
+  }
+
+  size_t flash_bytes = model.packed_vertices.size() * 4;
+  size_t ram_bytes = size_t(vertex_count) * 20;
+  for (auto & level : model.levels) {
+    for (auto const & c : level.chains) {
+      put_varint(level.packed_chains, unsigned(c.vertices.size() - 1));
+      put_varint(level.packed_chains, new_index[c.vertices[0]]);
+      for (size_t i = 1; i < c.vertices.size(); ++i) {
+        put_varint(level.packed_chains,
+                   zigzag(int(new_index[c.vertices[i]])
+                          - int(new_index[c.vertices[i - 1]])));
+      }
+    }
+    flash_bytes += level.packed_chains.size() + level.edges.size() * 12;
+    ram_bytes += (level.edges.size() + 2 * level.chains.size()) * 2;
+  }
+
+  std::fprintf(stderr, "Indexed edge rep requires:\n");
+  std::fprintf(stderr, " - %zu bytes of packed mesh and edge normals in "
+                       "Flash.\n", flash_bytes);
+  std::fprintf(stderr, " - %zu bytes of RAM once decoded.\n", ram_bytes);
+
+  return model;
+}
+
+
+/*******************************************************************************
+ * Output
+ */
+
+// Formats a number with as few digits as will read back exactly.  (Fifteen
+// digits always suffice for numbers that have a shorter form, since %g drops
+// trailing zeros.)
+static std::string number(double x) {
+  char buf[32];
+  for (int precision = 15; precision <= 17; ++precision) {
+    std::snprintf(buf, sizeof(buf), "%.*g", precision, x);
+    if (std::strtod(buf, nullptr) == x) break;
+  }
+  return buf;
+}
+
+static std::string vector(Vec3 const & v) {
+  return "{ " + number(v.x) + ", " + number(v.y) + ", " + number(v.z) + " }";
+}
+
+/*
+ * Rounds to the nearest half-precision value, ties to even, as the compiler
+ * will when it converts a literal to __fp16.  Half precision has 11
+ * significant bits, down to 2^-14, below which the spacing stays at 2^-24.
+ */
+static double to_half(double x) {
+  if (x == 0) return x;
+  int exp;
+  std::frexp(x, &exp);
+  auto const quantum = std::ldexp(1.0, std::max(exp, -13) - 11);
+  return std::nearbyint(x / quantum) * quantum;
+}
+
+/*
+ * Formats a number that will be stored in half precision.  Rounding it here
+ * first, five significant digits are enough to land on the same value, which
+ * keeps the output (and its compile time) down.
+ *
+ * A large mesh has millions of normal components but there are only so many
+ * half-precision values, so each is formatted once and remembered.  They're
+ * keyed by their bits, which keeps -0 apart from 0.
+ */
+static std::string const & half_number(double x) {
+  static std::unordered_map<std::uint64_t, std::string> formatted;
+  auto const h = to_half(x);
+  std::uint64_t bits;
+  std::memcpy(&bits, &h, sizeof(bits));
+  auto it = formatted.find(bits);
+  if (it == formatted.end()) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.5g", h);
+    it = formatted.emplace(bits, buf).first;
+  }
+  return it->second;
+}
+
+// Formats a unit vector that will be stored in half precision.
+static std::string half_vector(Vec3 const & v) {
+  return "{ " + half_number(v.x) + ", " + half_number(v.y) + ", "
+       + half_number(v.z) + " }";
+}
+
+static FILE * create(std::string const & path) {
+  auto const f = std::fopen(path.c_str(), "w");
+  if (!f) fail("can't create %s", path.c_str());
+  return f;
+}
+
+static void write_header(std::string const & outdir,
+                         std::vector<Model> const & models) {
+  unsigned max_vertices = 0;
+  size_t max_triangles = 0, max_lods = 0;
+  for (auto const & m : models) {
+    max_vertices = std::max(max_vertices, m.vertex_count);
+    max_triangles = std::max(max_triangles, m.triangles.size());
+    max_lods = std::max(max_lods, m.levels.size());
+  }
+
+  auto const f = create(outdir + "/model.h");
+  std::fprintf(f,
+      "#ifndef DEMO_ROOK_MODEL_H\n"
+      "#define DEMO_ROOK_MODEL_H\n"
+      "\n"
+      "#include \"demo/rook/mesh.h\"\n"
+      "\n"
+      "namespace demo {\n"
+      "namespace rook {\n"
+      "\n"
+      "// Largest counts of any model, for sizing buffers.\n"
+      "static constexpr unsigned max_vertex_count = %u;\n"
+      "static constexpr unsigned max_triangle_count = %zu;\n"
+      "static constexpr unsigned max_lod_count = %zu;\n"
+      "\n",
+      max_vertices, max_triangles, max_lods);
+  for (auto const & m : models) {
+    std::fprintf(f, "extern Model const %s_model;\n", m.name.c_str());
+  }
+  std::fprintf(f,
+      "\n"
+      "static constexpr unsigned model_count = %zu;\n"
+      "extern Model const * const models[model_count];\n"
+      "\n"
+      "}  // namespace rook\n"
+      "}  // namespace demo\n"
+      "\n"
+      "#endif  // DEMO_ROOK_MODEL_H\n",
+      models.size());
+  std::fclose(f);
+}
+
+static void write_model(FILE * f, Model const & m) {
+  auto const name = m.name.c_str();
+
+  std::fprintf(f, "\nstatic std::uint32_t const %s_packed_vertices[] = {\n",
+               name);
+  for (size_t i = 0; i < m.packed_vertices.size(); ++i) {
+    std::fprintf(f, "%s0x%08x,%s", i % 6 ? " " : "  ",
+                 unsigned(m.packed_vertices[i]),
+                 i % 6 == 5 || i + 1 == m.packed_vertices.size() ? "\n" : "");
+  }
+  std::fprintf(f, "};\n");
+
+  for (size_t l = 0; l < m.levels.size(); ++l) {
+    auto const & packed = m.levels[l].packed_chains;
+    std::fprintf(f, "static std::uint8_t const %s_lod%zu_chains[] = {\n",
+                 name, l);
+    for (size_t i = 0; i < packed.size(); ++i) {
+      std::fprintf(f, "%s0x%02x,%s", i % 12 ? " " : "  ", packed[i],
+                   i % 12 == 11 || i + 1 == packed.size() ? "\n" : "");
+    }
+    std::fprintf(f, "};\n");
+  }
+
+  // Outward unit normals of the two faces adjacent to each edge, in the
+  // order the chains visit the edges.  Edges on the boundary of an open mesh
+  // have only one face; repeat its normal.  Edges of degenerate faces only
+  // get a zero normal and are never drawn, but they coincide with other
+  // edges anyway.  Beyond two faces (not a manifold) we keep the first two.
+  for (size_t l = 0; l < m.levels.size(); ++l) {
+    auto const & level = m.levels[l];
+    std::fprintf(f,
+                 "static math::Vec3h const %s_lod%zu_edge_normals[][2] = {\n",
+                 name, l);
+    for (auto const & c : level.chains) {
+      for (auto id : c.edges) {
+        auto const & ns = level.edges.normals[id];
+        std::string n0 = "{ 0, 0, 0 }", n1 = n0;
+        if (!ns.empty()) {
+          n0 = half_vector(ns[0]);
+          n1 = half_vector(ns.size() > 1 ? ns[1] : ns[0]);
+        }
+        std::fprintf(f, "  { %s, %s },\n", n0.c_str(), n1.c_str());
+      }
+    }
+    std::fprintf(f, "};\n");
+  }
+
+  std::fprintf(f, "static PackedMesh const %s_lods[] {\n", name);
+  for (size_t l = 0; l < m.levels.size(); ++l) {
+    auto const & level = m.levels[l];
+    std::fprintf(f,
+        "  {\n"
+        "    %s,\n"
+        "    %s,\n"
+        "    %u, %s_packed_vertices,\n"
+        "    %zu, %zu, %s_lod%zu_chains,\n"
+        "    %s_lod%zu_edge_normals,\n"
+        "  },\n",
+        vector(m.box_min).c_str(), vector(m.quant_step).c_str(),
+        level.vertex_count, name,
+        level.edges.size(), level.chains.size(), name, l,
+        name, l);
+  }
+  std::fprintf(f, "};\n");
+
+  std::fprintf(f, "static std::uint16_t const %s_triangles[][3] = {\n", name);
+  for (auto const & t : m.triangles) {
+    std::fprintf(f, "  { %u, %u, %u },\n", t.v[0], t.v[1], t.v[2]);
+  }
+  std::fprintf(f, "};\n");
+
+  std::fprintf(f, "static math::Vec3h const %s_triangle_normals[] = {\n",
+               name);
+  for (auto const & t : m.triangles) {
+    std::fprintf(f, "  %s,\n", half_vector(t.normal).c_str());
+  }
+  std::fprintf(f, "};\n");
+
+  std::fprintf(f,
+      "Model const %s_model {\n"
+      "  %zu, %s_lods,\n"
+      "  %s, %s,\n"
+      "  %zu, %s_triangles, %s_triangle_normals,\n"
+      "};\n",
+      name,
+      m.levels.size(), name,
+      vector(m.bound_center).c_str(), number(m.bound_radius).c_str(),
+      m.triangles.size(), name, name);
+}
+
+static void write_source(std::string const & outdir,
+                         std::vector<Model> const & models) {
+  auto const f = create(outdir + "/model.cc");
+  std::fprintf(f,
+      "#include \"demo/rook/model.h\"\n"
+      "\n"
+      "namespace demo {\n"
+      "namespace rook {\n");
+  for (auto const & m : models) write_model(f, m);
+
+  std::fprintf(f, "\nModel const * const models[model_count] {\n");
+  for (auto const & m : models) {
+    std::fprintf(f, "  &%s_model,\n", m.name.c_str());
+  }
+  std::fprintf(f,
+      "};\n"
+      "\n"
+      "}  // namespace rook\n"
+      "}  // namespace demo\n");
+  std::fclose(f);
+}
+
+int main(int argc, char ** argv) {
+  if (argc < 3) fail("usage: %s <output-dir> <file.stl>...", argv[0]);
+  std::string const outdir = argv[1];
+
+  std::vector<Model> models;
+  for (int i = 2; i < argc; ++i) {
+    std::string name = argv[i];
+    auto const slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".stl") == 0) {
+      name.resize(name.size() - 4);
+    }
+    models.push_back(compile(name, read_stl(argv[i])));
+  }
+
+  std::fprintf(stderr, "Output going into %s\n", outdir.c_str());
+  write_header(outdir, models);
+  write_source(outdir, models);
+  return 0;
+}
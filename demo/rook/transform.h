@@ -0,0 +1,54 @@
+#ifndef DEMO_ROOK_TRANSFORM_H
+#define DEMO_ROOK_TRANSFORM_H
+
+#include "etl/math/matrix.h"
+#include "etl/math/vector.h"
+
+namespace demo {
+namespace rook {
+
+// Vertices are transformed in blocks of this many, so vertex arrays are
+// padded out to a multiple of it.
+static constexpr unsigned transform_block = 4;
+
+inline unsigned padded(unsigned count) {
+  return (count + transform_block - 1) / transform_block * transform_block;
+}
+
+/*
+ * Projects points through 'm' onto the screen.  The points come as separate
+ * arrays of X, Y and Z, and 'count' must be a multiple of transform_block.
+ *
+ * This gives the same result as multiplying each point by 'm' as a Vec4f
+ * with W=1 and dividing by W.  It's faster because it pulls the matrix's
+ * columns out once, and works through the coordinate arrays in blocks that
+ * the compiler can schedule without worrying about aliasing.
+ */
+inline void transform_points(etl::math::Mat4f const & m,
+                             float const * __restrict__ vx,
+                             float const * __restrict__ vy,
+                             float const * __restrict__ vz,
+                             etl::math::Vec2i * __restrict__ out,
+                             unsigned count) {
+  using etl::math::Vec4f;
+
+  Vec4f const c0 = m * Vec4f{1, 0, 0, 0},
+              c1 = m * Vec4f{0, 1, 0, 0},
+              c2 = m * Vec4f{0, 0, 1, 0},
+              c3 = m * Vec4f{0, 0, 0, 1};
+
+  for (unsigned i = 0; i < count; i += transform_block) {
+    for (unsigned j = i; j < i + transform_block; ++j) {
+      auto const x = c0.x * vx[j] + c1.x * vy[j] + c2.x * vz[j] + c3.x;
+      auto const y = c0.y * vx[j] + c1.y * vy[j] + c2.y * vz[j] + c3.y;
+      auto const w = c0.w * vx[j] + c1.w * vy[j] + c2.w * vz[j] + c3.w;
+      auto const inv_w = 1 / w;
+      out[j] = { static_cast<int>(x * inv_w), static_cast<int>(y * inv_w) };
+    }
+  }
+}
+
+}  // namespace rook
+}  // namespace demo
+
+#endif  // DEMO_ROOK_TRANSFORM_H
@@ -0,0 +1,113 @@
+/*
+ * Host test and benchmark for transform_points: checks it against the plain
+ * Mat4f * Vec4f projection, over every vertex of the rook, from viewpoints
+ * all the way around it and at both of the demo's eye distances.
+ *
+ * The batched version multiplies by 1/w where the reference divides by w, so
+ * the two may round differently; they must agree to within a pixel.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "etl/math/affine_transform.h"
+#include "etl/math/matrix.h"
+#include "etl/math/vector.h"
+
+#include "demo/rook/model.h"
+#include "demo/rook/transform.h"
+
+using etl::math::Mat4f;
+using etl::math::Vec2i;
+using etl::math::Vec3f;
+using etl::math::Vec4f;
+
+namespace xf = etl::math::affine_transform;
+
+using demo::rook::padded;
+using demo::rook::rook_model;
+using demo::rook::transform_points;
+
+// The wireframe Rook scene's view: see View in rook.cc.
+static Mat4f view(float orbit, float tilt, float distance) {
+  return xf::translate(Vec3f{400, 200, 0})
+       * xf::scale(Vec3f{300, 300, 1})
+       * xf::persp(-10, -10, 10, 10, 20, 100)
+       * xf::translate(Vec3f{0, 0, -distance})
+       * xf::rotate_y(orbit)
+       * xf::rotate_z(tilt);
+}
+
+static Vec2i reference(Mat4f const & m, Vec3f const & p) {
+  auto const v = m * Vec4f{p.x, p.y, p.z, 1};
+  return { static_cast<int>(v.x / v.w), static_cast<int>(v.y / v.w) };
+}
+
+int main() {
+  auto const & mesh = rook_model.mesh();
+  auto const count = padded(mesh.vertex_count);
+
+  std::vector<float> vx(count), vy(count), vz(count);
+  std::vector<Vec2i> out(count);
+  for (unsigned i = 0; i < count; ++i) {
+    auto const v = i < mesh.vertex_count ? mesh.vertex(i) : Vec3f{0, 0, 0};
+    vx[i] = v.x;
+    vy[i] = v.y;
+    vz[i] = v.z;
+  }
+
+  unsigned checked = 0, inexact = 0;
+  for (float distance : {70.f, 210.f}) {
+    for (int step = 0; step < 64; ++step) {
+      auto const m = view(step * 0.1f, step * 0.037f, distance);
+      transform_points(m, vx.data(), vy.data(), vz.data(), out.data(),
+                       count);
+      for (unsigned i = 0; i < mesh.vertex_count; ++i) {
+        auto const want = reference(m, mesh.vertex(i));
+        auto const dx = std::abs(out[i].x - want.x);
+        auto const dy = std::abs(out[i].y - want.y);
+        if (dx > 1 || dy > 1) {
+          std::printf("FAIL: vertex %u at distance %g, step %d: "
+                      "got (%d, %d), want (%d, %d)\n",
+                      i, distance, step,
+                      out[i].x, out[i].y, want.x, want.y);
+          return 1;
+        }
+        if (dx || dy) ++inexact;
+        ++checked;
+      }
+    }
+  }
+  std::printf("%u vertices checked, %u off by one pixel.\n",
+              checked, inexact);
+
+  // Benchmark.  This measures the host, not the Cortex-M4, but shows the
+  // relative cost of the two approaches.
+  static constexpr unsigned rounds = 2000;
+  auto const m = view(0.5f, 0.2f, 70);
+  using Clock = std::chrono::steady_clock;
+
+  auto const t0 = Clock::now();
+  for (unsigned r = 0; r < rounds; ++r) {
+    transform_points(m, vx.data(), vy.data(), vz.data(), out.data(), count);
+    asm volatile("" : : "r"(out.data()) : "memory");
+  }
+  auto const t1 = Clock::now();
+  for (unsigned r = 0; r < rounds; ++r) {
+    for (unsigned i = 0; i < count; ++i) {
+      out[i] = reference(m, Vec3f{vx[i], vy[i], vz[i]});
+    }
+    asm volatile("" : : "r"(out.data()) : "memory");
+  }
+  auto const t2 = Clock::now();
+
+  auto const per_vertex = [&](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count()
+         / (double(rounds) * count);
+  };
+  std::printf("batched: %.2f ns/vertex, scalar: %.2f ns/vertex\n",
+              per_vertex(t1 - t0), per_vertex(t2 - t1));
+  return 0;
+}
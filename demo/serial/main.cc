@@ -2,30 +2,21 @@
 
 #include "etl/armv7m/implicit_crt0.h"
 
-#include "etl/stm32f4xx/ahb.h"
-#include "etl/stm32f4xx/apb.h"
-#include "etl/stm32f4xx/gpio.h"
-#include "etl/stm32f4xx/interrupts.h"
 #include "etl/stm32f4xx/rcc.h"
-#include "etl/stm32f4xx/usart.h"
 
 #include "vga/arena.h"
 #include "vga/rast/text_10x16.h"
 #include "vga/timing.h"
 #include "vga/vga.h"
 
+#include "demo/ansi_terminal.h"
 #include "demo/config.h"
+#include "demo/serial/uart.h"
 #include "demo/terminal.h"
 
 DEMO_REQUIRE_RESOLUTION(800, 600)
 
-using etl::stm32f4xx::AhbPeripheral;
-using etl::stm32f4xx::ApbPeripheral;
-using etl::stm32f4xx::gpioa;
 using etl::stm32f4xx::rcc;
-using etl::stm32f4xx::Usart;
-using etl::stm32f4xx::usart2;
-using etl::stm32f4xx::Gpio;
 
 using Pixel = vga::Rasterizer::Pixel;
 
@@ -35,7 +26,7 @@ using Pixel = vga::Rasterizer::Pixel;
 
 struct TextDemo : public demo::Terminal {
   TextDemo() : demo::Terminal(800, 600) {
-    rasterizer.clear_framebuffer(demo::blue);
+    clear(demo::blue);
   }
 
   vga::Band const band{&rasterizer, 600, nullptr};
@@ -87,88 +78,9 @@ struct TextDemo : public demo::Terminal {
  * The actual demo.
  */
 
-static void usart2_init() {
-  rcc.enable_clock(AhbPeripheral::gpioa);
-  rcc.leave_reset(AhbPeripheral::gpioa);
-
-  rcc.enable_clock(ApbPeripheral::usart2);
-  rcc.leave_reset(ApbPeripheral::usart2);
-
-  // Enable the USART before other actions.
-  usart2.write_cr1(Usart::cr1_value_t().with_ue(true));
-
-  float clock = rcc.get_clock_hz(ApbPeripheral::usart2);
-  unsigned brr = static_cast<unsigned>(clock / 115200.f + 0.5f);
-  usart2.write_brr(Usart::brr_value_t()
-                   .with_div_mantissa(brr >> 4)
-                   .with_div_fraction(brr & 0xF));
-
-  // Turn on the transmitter.
-  usart2.write_cr1(usart2.read_cr1()
-                   .with_te(true)
-                   .with_re(true));
-
-  unsigned short pins = Gpio::p2 | Gpio::p3;
-  gpioa.set_mode(pins, Gpio::Mode::alternate);
-  gpioa.set_output_type(pins, Gpio::OutputType::push_pull);
-  gpioa.set_output_speed(pins, Gpio::OutputSpeed::medium_25mhz);
-  gpioa.set_pull(pins, Gpio::Pull::none);
-  gpioa.set_alternate_function(pins, 7);  // USART2_TX/RX
-}
-
-template <unsigned N>
-class Queue {
-public:
-  Queue() = default;
-
-  bool offer(unsigned char c) {
-    if (is_full()) return false;
-    _bytes[_writer++ % N] = c;
-    return true;
-  }
-
-  bool take(unsigned char &c) {
-    if (is_empty()) return false;
-    c = _bytes[_reader++ % N];
-    return true;
-  }
-
-  bool is_full() const {
-    return _writer == _reader + N;
-  }
-
-  bool is_empty() const {
-    return _writer == _reader;
-  }
-
-private:
-  unsigned char _bytes[N];
-  unsigned volatile _reader;
-  unsigned volatile _writer;
-};
-
-static Queue<16> usart_rx_queue;
-static Queue<16> usart_tx_queue;
-
-static void usart2_send(unsigned char b) {
-  (void) usart_tx_queue.offer(b);
-}
-
-__attribute__((section(".ramcode")))
-static void usart2_poll() {
-  auto sr = usart2.read_sr();
-
-  if (sr.get_rxne()) {
-    usart_rx_queue.offer(usart2.read_dr().get_dr());
-  }
-
-  if (sr.get_txe()) {
-    unsigned char c;
-    if (usart_tx_queue.take(c)) {
-      usart2.write_dr(c);
-    }
-  }
-}
+// The UART's buffers are written by DMA, which can't reach CCM -- so this
+// lives in .bss, rather than in the arena, which may hand out CCM.
+static demo::serial::Uart uart;
 
 static void startup_banner(TextDemo & d) {
   using namespace demo;  // for colors
@@ -230,7 +142,7 @@ int main() {
 
   auto d = vga::arena_make<TextDemo>();
 
-  usart2_init();
+  uart.init(115200);
 
   startup_banner(*d);
 
@@ -239,32 +151,26 @@ int main() {
 
   vga::video_on();
 
-  // Wait for first character.
-  while (true) {
-    unsigned char c;
-    bool has_c = usart_rx_queue.take(c);
-    if (!has_c) continue;
-
-    d->rasterizer.clear_framebuffer(demo::blue);
-    d->cursor_to(0, 0);
-    usart2_send(c);
-    d->type(demo::white, demo::blue, c);
-    break;
-  }
+  // Waits for input, polling the UART during each vblank, then returns the
+  // number of bytes read into 'buffer'.
+  unsigned char buffer[64];
+  auto const receive = [&buffer]() -> unsigned {
+    while (true) {
+      if (auto n = uart.read(buffer, sizeof(buffer))) return n;
+      vga::sync_to_vblank();
+      uart.poll();
+    }
+  };
 
-  // Subsequent characters.
-  while (true) {
-    unsigned char c;
-    bool has_c = usart_rx_queue.take(c);
-    if (!has_c) continue;
+  // Leave the banner up until the first input arrives.
+  auto n = receive();
 
-    usart2_send(c);
-    d->type(demo::white, demo::blue, c);
+  // From here on the screen acts as a VT100-style terminal, starting blank.
+  demo::AnsiTerminal ansi{*d, demo::white, demo::blue};
+  while (true) {
+    uart.write(buffer, n);
+    ansi.write(reinterpret_cast<char const *>(buffer), n);
+    n = receive();
   }
   __builtin_unreachable();
 }
-
-__attribute__((section(".ramcode")))
-void vga_hblank_interrupt() {
-  usart2_poll();
-}
@@ -0,0 +1,146 @@
+/*
+ * Host tool for flooding the serial demo's receive path.
+ *
+ * Reads a byte stream from standard input -- a pipe, a file, or a pty -- and
+ * plays it through a simulation of the demo at the given baud rate: each
+ * 60 Hz frame, a circular DMA of Uart::rx_buffer_size bytes receives a
+ * frame's worth of bytes, RxTracker is polled once, as Uart::poll_rx polls
+ * it during vblank, and the unread bytes are read out 64 at a time and given
+ * to an AnsiTerminal on an 800x600 Terminal, as main.cc does.
+ *
+ * It reports the bytes received and delivered, rx_overruns, and how fast
+ * the host got through the terminal work.  The host is much faster than the
+ * demo, so the throughput is only good for comparing changes; what carries
+ * over is whether the buffer keeps up with the baud rate at one poll per
+ * frame.
+ *
+ *   some-program | rx_flood [baud]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "demo/ansi_terminal.h"
+#include "demo/serial/rx_tracker.h"
+#include "demo/serial/uart.h"
+#include "demo/terminal.h"
+
+using demo::serial::RxTracker;
+using demo::serial::Uart;
+
+static constexpr unsigned size = Uart::rx_buffer_size;
+static constexpr unsigned frame_hz = 60;
+
+// A circular DMA stream receiving into the buffer, with the flags and NDTR
+// that RxTracker needs.
+struct Dma {
+  unsigned char buffer[size];
+  unsigned long written;
+  bool half_flag;
+  bool end_flag;
+
+  void receive(unsigned char const * data, unsigned count) {
+    for (unsigned i = 0; i < count; ++i) {
+      buffer[written % size] = data[i];
+      ++written;
+      if (written % size == size / 2) half_flag = true;
+      if (written % size == 0) end_flag = true;
+    }
+  }
+
+  unsigned remaining() const {
+    return size - written % size;
+  }
+};
+
+static Dma dma;
+static RxTracker<size> tracker;
+static Uart::Counters counters;
+
+// As Uart::poll_rx.
+static void poll_rx() {
+  auto const u = tracker.update(dma.half_flag, dma.end_flag,
+                                dma.remaining());
+  if (u.clear_half) dma.half_flag = false;
+  if (u.clear_end) dma.end_flag = false;
+  if (u.overrun) ++counters.rx_overruns;
+}
+
+// As Uart::read.
+static unsigned read_rx(unsigned char * buffer, unsigned max) {
+  auto const count = max < tracker.unread() ? max : tracker.unread();
+  auto pos = tracker.read_pos();
+  for (unsigned i = 0; i < count; ++i) {
+    buffer[i] = dma.buffer[pos];
+    if (++pos == size) pos = 0;
+  }
+  tracker.consume(count);
+  counters.received += count;
+  return count;
+}
+
+int main(int argc, char ** argv) {
+  unsigned long const baud = argc > 1 ? std::strtoul(argv[1], nullptr, 0)
+                                      : 115200;
+  if (argc > 2 || baud == 0) {
+    std::fprintf(stderr, "usage: %s [baud] < input\n", argv[0]);
+    return 2;
+  }
+
+  demo::Terminal term(800, 600);
+  demo::AnsiTerminal ansi{term, demo::white, demo::blue};
+  tracker.reset();
+
+  // Ten bits to the byte on the wire.  The remainder carries over, so that
+  // rates that aren't a whole number of bytes per frame come out right.
+  static constexpr unsigned long bits_per_frame = 10 * frame_hz;
+  unsigned long credit = 0;
+
+  std::chrono::steady_clock::duration busy{}, worst{};
+  unsigned long frames = 0;
+  bool input_done = false;
+
+  while (!input_done || tracker.unread()) {
+    ++frames;
+
+    if (!input_done) {
+      credit += baud;
+      static unsigned char incoming[64 * 1024];
+      auto want = credit / bits_per_frame;
+      credit %= bits_per_frame;
+      while (want) {
+        auto const chunk = want < sizeof(incoming) ? want : sizeof(incoming);
+        auto const n = std::fread(incoming, 1, chunk, stdin);
+        dma.receive(incoming, unsigned(n));
+        if (n < chunk) {
+          input_done = true;
+          break;
+        }
+        want -= n;
+      }
+    }
+
+    poll_rx();
+
+    auto const start = std::chrono::steady_clock::now();
+    unsigned char buffer[64];
+    while (auto const n = read_rx(buffer, sizeof(buffer))) {
+      ansi.write(reinterpret_cast<char const *>(buffer), n);
+    }
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    busy += elapsed;
+    if (elapsed > worst) worst = elapsed;
+  }
+
+  auto const seconds = std::chrono::duration<double>(busy).count();
+  std::printf("%lu baud, %u byte buffer: %lu frames (%.1f s)\n",
+              baud, size, frames, double(frames) / frame_hz);
+  std::printf("received %lu, delivered %u, rx_overruns %u\n",
+              dma.written, counters.received, counters.rx_overruns);
+  std::printf("host: %.1f Mbyte/s through AnsiTerminal, "
+              "worst frame %.3f ms\n",
+              seconds > 0 ? counters.received / seconds / 1e6 : 0.,
+              std::chrono::duration<double, std::milli>(worst).count());
+  return 0;
+}
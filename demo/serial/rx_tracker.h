@@ -0,0 +1,94 @@
+#ifndef DEMO_SERIAL_RX_TRACKER_H
+#define DEMO_SERIAL_RX_TRACKER_H
+
+namespace demo {
+namespace serial {
+
+/*
+ * Keeps track of a DMA stream receiving forever into a circular buffer of N
+ * bytes: where the DMA has got to, which bytes are still unread, and whether
+ * any were overwritten before being read.
+ *
+ * This knows nothing of the hardware.  The caller reads the stream's
+ * half-transfer and transfer-complete flags, then its NDTR, hands them to
+ * update(), and clears the flags it's told to.  Keeping the registers out
+ * means the accounting can be tested on a host against a simulated DMA.
+ */
+template <unsigned N>
+class RxTracker {
+public:
+  struct Update {
+    bool clear_half;  // Clear the half-transfer flag.
+    bool clear_end;   // Clear the transfer-complete flag.
+    bool overrun;     // Unread bytes were overwritten, and have been lost.
+  };
+
+  void reset() {
+    _dma_pos = _read = _unread = 0;
+  }
+
+  /*
+   * Accounts for the DMA's progress.  'half_flag' and 'end_flag' are the
+   * stream's flags, which must be read before 'remaining', its NDTR, so that
+   * a flag can't be raised after the position is read and confuse the next
+   * update.
+   */
+  Update update(bool half_flag, bool end_flag, unsigned remaining) {
+    auto const pos = (N - remaining) % N;
+
+    // Taking the short way round from the last position, the DMA has moved
+    // this far.  If it actually lapped the buffer, it will have raised a
+    // flag that the short way doesn't account for.
+    auto distance = (pos + N - _dma_pos) % N;
+    auto passed_half = reaches(_dma_pos, distance, N / 2);
+    auto passed_end = reaches(_dma_pos, distance, N);
+    if ((half_flag && !passed_half) || (end_flag && !passed_end)) {
+      // A lap passes both marks, and so accounts for both flags.
+      distance += N;
+      passed_half = passed_end = true;
+    }
+
+    // Clear the flags seen, and those the movement accounts for even if they
+    // were raised after being read.
+    Update u { half_flag || passed_half, end_flag || passed_end, false };
+
+    _dma_pos = pos;
+    _unread += distance;
+    if (_unread > N) {
+      // Some unread bytes have been overwritten, and there's no telling
+      // which: start again from here.
+      u.overrun = true;
+      _read = pos;
+      _unread = 0;
+    }
+    return u;
+  }
+
+  // Index of the next unread byte in the buffer.
+  unsigned read_pos() const { return _read; }
+
+  unsigned unread() const { return _unread; }
+
+  // Marks 'count' bytes, no more than unread(), as read.
+  void consume(unsigned count) {
+    _read = (_read + count) % N;
+    _unread -= count;
+  }
+
+private:
+  unsigned _dma_pos;  // Where the DMA had got to at last update.
+  unsigned _read;     // Next byte to read.
+  unsigned _unread;
+
+  // Says whether moving 'distance' forward from 'pos' around the buffer
+  // reaches 'mark', which is within the buffer or at its end.
+  static bool reaches(unsigned pos, unsigned distance, unsigned mark) {
+    return pos < mark ? pos + distance >= mark
+                      : pos + distance >= mark + N;
+  }
+};
+
+}  // namespace serial
+}  // namespace demo
+
+#endif  // DEMO_SERIAL_RX_TRACKER_H
@@ -0,0 +1,191 @@
+/*
+ * Host test for RxTracker, against a simulated DMA stream.
+ *
+ * The simulation writes a numbered byte stream into a circular buffer,
+ * raising the half-transfer and transfer-complete flags as the hardware
+ * would, and is polled the way Uart::poll_rx polls the real stream --
+ * including the DMA moving on between the flags being read and NDTR.  A
+ * reader then checks that the bytes RxTracker hands out are the ones that
+ * arrived, in order, and that overruns are reported exactly when more than
+ * a buffer's worth went unread.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <random>
+
+#include "demo/serial/rx_tracker.h"
+
+using demo::serial::RxTracker;
+
+static constexpr unsigned size = 64;
+
+// The stream as the DMA would write it: byte i of the stream is i % 251, so
+// that it doesn't repeat with any period the buffer has.
+static unsigned char stream_byte(unsigned long i) {
+  return static_cast<unsigned char>(i % 251);
+}
+
+struct Dma {
+  unsigned char buffer[size];
+  unsigned long written;  // Bytes written since the start.
+  bool half_flag;
+  bool end_flag;
+
+  void receive(unsigned count) {
+    for (unsigned i = 0; i < count; ++i) {
+      buffer[written % size] = stream_byte(written);
+      ++written;
+      if (written % size == size / 2) half_flag = true;
+      if (written % size == 0) end_flag = true;
+    }
+  }
+
+  // NDTR counts down to zero and reloads at once in circular mode, so it
+  // never reads as zero.
+  unsigned remaining() const {
+    return size - written % size;
+  }
+};
+
+struct Test {
+  Dma dma;
+  RxTracker<size> tracker;
+  unsigned long consumed;  // Stream bytes read or lost.
+  unsigned overruns;
+  unsigned failures;
+
+  Test() : dma(), consumed(0), overruns(0), failures(0) {
+    tracker.reset();
+  }
+
+  // Polls like Uart::poll_rx, with the DMA receiving 'racing' more bytes
+  // between the flags and NDTR being read.
+  void poll(unsigned racing) {
+    auto const half = dma.half_flag, end = dma.end_flag;
+    dma.receive(racing);
+    auto const u = tracker.update(half, end, dma.remaining());
+    if (u.clear_half) dma.half_flag = false;
+    if (u.clear_end) dma.end_flag = false;
+
+    // Everything up to NDTR's position counts; bytes received after it are
+    // for the next poll.
+    auto const unread = dma.written - consumed;
+    if (u.overrun) {
+      ++overruns;
+      if (unread <= size) {
+        fail("overrun reported with %lu unread", unread);
+      }
+      consumed = dma.written;
+    } else if (unread > size) {
+      fail("%lu unread, but no overrun reported", unread);
+    } else if (tracker.unread() != unread) {
+      fail("tracker has %u unread, expected %lu", tracker.unread(), unread);
+    }
+  }
+
+  // Reads up to 'max' bytes, checking them against the stream.
+  void read(unsigned max) {
+    auto const count = max < tracker.unread() ? max : tracker.unread();
+    auto pos = tracker.read_pos();
+    for (unsigned i = 0; i < count; ++i) {
+      if (dma.buffer[pos] != stream_byte(consumed)) {
+        fail("byte %lu of the stream is wrong", consumed);
+        return;
+      }
+      pos = (pos + 1) % size;
+      ++consumed;
+    }
+    tracker.consume(count);
+  }
+
+  __attribute__((format(printf, 2, 3)))
+  void fail(char const * format, ...) {
+    if (failures++ < 10) {
+      std::printf("FAIL: after %lu bytes: ", dma.written);
+      va_list args;
+      va_start(args, format);
+      std::vprintf(format, args);
+      va_end(args);
+      std::printf("\n");
+    }
+  }
+};
+
+// Fills the buffer exactly, between polls and across a poll, and checks
+// that it's all readable.
+static unsigned test_exactly_full() {
+  unsigned failures = 0;
+  for (unsigned start = 0; start < size; ++start) {
+    Test t;
+    t.dma.receive(start);
+    t.poll(0);
+    t.read(size);
+
+    t.dma.receive(size);
+    t.poll(0);
+    t.read(size);
+
+    t.dma.receive(size - 5);
+    t.poll(5);
+    t.read(size);
+
+    if (t.overruns) t.fail("%u overruns with the buffer just full",
+                           t.overruns);
+    if (t.consumed != t.dma.written) t.fail("%lu bytes not read",
+                                            t.dma.written - t.consumed);
+    failures += t.failures;
+  }
+  return failures;
+}
+
+// Overfills the buffer by one byte, and checks that it's reported.
+static unsigned test_one_over() {
+  unsigned failures = 0;
+  for (unsigned start = 0; start < size; ++start) {
+    Test t;
+    t.dma.receive(start);
+    t.poll(0);
+    t.read(size);
+
+    t.dma.receive(size + 1);
+    t.poll(0);
+    if (t.overruns != 1) t.fail("%u overruns, expected one", t.overruns);
+
+    // And then carries on from where the DMA is.
+    t.dma.receive(10);
+    t.poll(0);
+    t.read(size);
+    failures += t.failures;
+  }
+  return failures;
+}
+
+// Random traffic and reads, falling behind by up to one and a half buffers
+// between polls -- beyond that, a lap can go unnoticed.  Between the flags
+// and NDTR being read, the DMA can move a byte or two at most: a lap then
+// would also go unnoticed, as its flags weren't seen.
+static unsigned test_random() {
+  std::mt19937 rng(1);
+  Test t;
+  for (unsigned i = 0; i < 1000000 && !t.failures; ++i) {
+    auto const movement = unsigned(rng() % (size * 3 / 2));
+    auto const racing = movement < 2 ? movement : unsigned(rng() % 3);
+    t.dma.receive(movement - racing);
+    t.poll(racing);
+    t.read(rng() % 4 == 0 ? unsigned(rng() % size) : size);
+  }
+  std::printf("Random: %lu bytes, %u overruns.\n", t.dma.written, t.overruns);
+  if (!t.overruns) t.fail("no overruns in random traffic");
+  return t.failures;
+}
+
+int main() {
+  auto const failures = test_exactly_full() + test_one_over() + test_random();
+  if (failures) {
+    std::printf("%u failures\n", failures);
+    return 1;
+  }
+  std::printf("All tests passed.\n");
+  return 0;
+}
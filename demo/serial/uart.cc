@@ -0,0 +1,162 @@
+#include "demo/serial/uart.h"
+
+#include <cstdint>
+
+#include "etl/stm32f4xx/ahb.h"
+#include "etl/stm32f4xx/apb.h"
+#include "etl/stm32f4xx/dma.h"
+#include "etl/stm32f4xx/gpio.h"
+#include "etl/stm32f4xx/rcc.h"
+#include "etl/stm32f4xx/usart.h"
+
+using etl::stm32f4xx::AhbPeripheral;
+using etl::stm32f4xx::ApbPeripheral;
+using etl::stm32f4xx::Dma;
+using etl::stm32f4xx::dma1;
+using etl::stm32f4xx::gpioa;
+using etl::stm32f4xx::rcc;
+using etl::stm32f4xx::Usart;
+using etl::stm32f4xx::usart2;
+using etl::stm32f4xx::Gpio;
+
+namespace demo {
+namespace serial {
+
+// USART2's requests go to DMA1 channel 4, on stream 5 for receive and stream
+// 6 for transmit.
+static constexpr unsigned dma_channel = 4;
+static auto & rx_stream = dma1.stream[5];
+static auto & tx_stream = dma1.stream[6];
+
+static constexpr std::uint32_t usart2_dr_address = 0x40004404;
+
+/*
+ * DMA can't see the alias of SRAM112 at address zero, which is where .bss
+ * lives, so addresses there are moved to SRAM112's real location.
+ */
+static std::uint32_t dma_address(void const * p) {
+  auto const a = reinterpret_cast<std::uintptr_t>(p);
+  return a < 112 * 1024 ? a + 0x20000000 : a;
+}
+
+void Uart::init(unsigned baud) {
+  _rx_tracker.reset();
+  _tx_in_flight = 0;
+  _counters = {};
+
+  rcc.enable_clock(AhbPeripheral::gpioa);
+  rcc.leave_reset(AhbPeripheral::gpioa);
+
+  rcc.enable_clock(AhbPeripheral::dma1);
+  rcc.leave_reset(AhbPeripheral::dma1);
+
+  rcc.enable_clock(ApbPeripheral::usart2);
+  rcc.leave_reset(ApbPeripheral::usart2);
+
+  // Enable the USART before other actions.
+  usart2.write_cr1(Usart::cr1_value_t().with_ue(true));
+
+  float clock = rcc.get_clock_hz(ApbPeripheral::usart2);
+  unsigned brr = static_cast<unsigned>(clock / baud + 0.5f);
+  usart2.write_brr(Usart::brr_value_t()
+                   .with_div_mantissa(brr >> 4)
+                   .with_div_fraction(brr & 0xF));
+
+  // Have the USART request DMA in both directions.
+  usart2.write_cr3(usart2.read_cr3()
+                   .with_dmar(true)
+                   .with_dmat(true));
+
+  // Receive forever into the circular buffer.
+  rx_stream.write_par(usart2_dr_address);
+  rx_stream.write_m0ar(dma_address(_rx));
+  rx_stream.write_ndtr(rx_buffer_size);
+  rx_stream.write_cr(Dma::Stream::cr_value_t()
+                     .with_chsel(dma_channel)
+                     .with_dir(Dma::Stream::cr_value_t::dir_t::
+                               peripheral_to_memory)
+                     .with_circ(true)
+                     .with_minc(true)
+                     .with_en(true));
+
+  // Transmit is set up here, and started by poll_tx as needed.
+  tx_stream.write_par(usart2_dr_address);
+  tx_stream.write_cr(Dma::Stream::cr_value_t()
+                     .with_chsel(dma_channel)
+                     .with_dir(Dma::Stream::cr_value_t::dir_t::
+                               memory_to_peripheral)
+                     .with_minc(true));
+
+  // Turn on the transmitter and receiver.
+  usart2.write_cr1(usart2.read_cr1()
+                   .with_te(true)
+                   .with_re(true));
+
+  unsigned short pins = Gpio::p2 | Gpio::p3;
+  gpioa.set_mode(pins, Gpio::Mode::alternate);
+  gpioa.set_output_type(pins, Gpio::OutputType::push_pull);
+  gpioa.set_output_speed(pins, Gpio::OutputSpeed::medium_25mhz);
+  gpioa.set_pull(pins, Gpio::Pull::none);
+  gpioa.set_alternate_function(pins, 7);  // USART2_TX/RX
+}
+
+void Uart::poll() {
+  poll_rx();
+  poll_tx();
+}
+
+void Uart::poll_rx() {
+  auto const flags = dma1.read_hisr();
+  auto const remaining = rx_stream.read_ndtr().get_ndt();
+  auto const u = _rx_tracker.update(flags.get_htif5(),
+                                    flags.get_tcif5(),
+                                    remaining);
+  dma1.write_hifcr(Dma::hifcr_value_t()
+                   .with_chtif5(u.clear_half)
+                   .with_ctcif5(u.clear_end));
+  if (u.overrun) ++_counters.rx_overruns;
+}
+
+void Uart::poll_tx() {
+  // The stream disables itself when a transfer completes.
+  if (tx_stream.read_cr().get_en()) return;
+
+  _tx.release(_tx_in_flight);
+  _tx_in_flight = 0;
+
+  auto const span = _tx.read_span();
+  if (span.count == 0) return;
+
+  dma1.write_hifcr(Dma::hifcr_value_t()
+                   .with_cfeif6(true)
+                   .with_cdmeif6(true)
+                   .with_cteif6(true)
+                   .with_chtif6(true)
+                   .with_ctcif6(true));
+  tx_stream.write_m0ar(dma_address(span.data));
+  tx_stream.write_ndtr(span.count);
+  tx_stream.write_cr(tx_stream.read_cr().with_en(true));
+
+  _tx_in_flight = span.count;
+  _counters.sent += span.count;
+}
+
+unsigned Uart::read(unsigned char * buffer, unsigned max) {
+  auto const unread = _rx_tracker.unread();
+  auto const count = max < unread ? max : unread;
+  auto pos = _rx_tracker.read_pos();
+  for (unsigned i = 0; i < count; ++i) {
+    buffer[i] = _rx[pos];
+    if (++pos == rx_buffer_size) pos = 0;
+  }
+  _rx_tracker.consume(count);
+  _counters.received += count;
+  return count;
+}
+
+void Uart::write(unsigned char const * data, unsigned count) {
+  _counters.tx_dropped += count - _tx.write(data, count);
+}
+
+}  // namespace serial
+}  // namespace demo
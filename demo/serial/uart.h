@@ -0,0 +1,71 @@
+#ifndef DEMO_SERIAL_UART_H
+#define DEMO_SERIAL_UART_H
+
+#include "demo/spsc_ring.h"
+#include "demo/serial/rx_tracker.h"
+
+namespace demo {
+namespace serial {
+
+/*
+ * USART2, with DMA1 moving bytes in both directions, so that no interrupt
+ * handler needs to service it.
+ *
+ * Reception runs continuously into a circular buffer.  poll() checks how far
+ * the DMA has got and queues the new bytes for read().  Bytes given to
+ * write() go into a ring, and poll() has the DMA send them straight from
+ * there once the previous batch has gone.
+ *
+ * poll() touches the DMA controller, which lives on AHB1, and so must only
+ * be called outside of active video -- in practice, once per vblank.  The
+ * rest works from RAM and may be called at any time.  Polling and reading
+ * once per frame keeps up as long as the receive buffer lasts a frame: about
+ * 120 kbyte/s, or 1.2 Mbaud.  Falling behind by more than a buffer's worth
+ * is counted as an overrun, though a stall long enough for the DMA to lap
+ * the buffer twice may go unnoticed.
+ *
+ * Instances must not be in CCM, where DMA can't reach them.
+ */
+class Uart {
+public:
+  static constexpr unsigned rx_buffer_size = 2048;
+  static constexpr unsigned tx_buffer_size = 256;
+
+  struct Counters {
+    unsigned received;     // Bytes delivered to read().
+    unsigned rx_overruns;  // Times unread bytes were overwritten, and lost.
+    unsigned sent;         // Bytes handed to the transmit DMA.
+    unsigned tx_dropped;   // Bytes not sent because the ring was full.
+  };
+
+  void init(unsigned baud);
+
+  void poll();
+
+  // Copies up to 'max' received bytes into 'buffer', returning the count.
+  unsigned read(unsigned char * buffer, unsigned max);
+
+  // Queues bytes for transmission from the next poll.  Any that don't fit
+  // are dropped and counted.
+  void write(unsigned char const * data, unsigned count);
+
+  Counters const & get_counters() const { return _counters; }
+
+private:
+  unsigned char _rx[rx_buffer_size];
+  SpscRing<unsigned char, tx_buffer_size> _tx;
+
+  RxTracker<rx_buffer_size> _rx_tracker;
+
+  unsigned _tx_in_flight;  // Bytes at the front of _tx being sent by DMA.
+
+  Counters _counters;
+
+  void poll_rx();
+  void poll_tx();
+};
+
+}  // namespace serial
+}  // namespace demo
+
+#endif  // DEMO_SERIAL_UART_H
@@ -0,0 +1,153 @@
+#ifndef DEMO_SPSC_RING_H
+#define DEMO_SPSC_RING_H
+
+#include <atomic>
+
+namespace demo {
+
+/*
+ * A ring buffer of N elements of type T, for passing data from one producer
+ * to one consumer without locks -- e.g. from an interrupt handler to thread
+ * code, or between threads on a host.  N must be a power of two.
+ *
+ * Each side owns one free-running index and only reads the other's.  The
+ * indices are atomics with release stores and acquire loads, so that
+ * elements are visible before the index that publishes them.  On the
+ * Cortex-M4 this compiles to plain loads and stores with a DMB alongside,
+ * which also orders them for DMA.
+ *
+ * Besides single elements, each side can work on spans: the largest
+ * contiguous run of free or filled slots, which can be handed to memcpy or
+ * DMA and then committed or released in one go.
+ */
+template <typename T, unsigned N>
+class SpscRing {
+  static_assert(N != 0 && (N & (N - 1)) == 0,
+                "SpscRing size must be a power of two");
+
+public:
+  struct Span {
+    T * data;
+    unsigned count;
+  };
+
+  SpscRing() : _head(0), _tail(0) {}
+
+  SpscRing(SpscRing const &) = delete;
+  SpscRing & operator=(SpscRing const &) = delete;
+
+  static constexpr unsigned capacity = N;
+
+  /*
+   * Producer side.
+   */
+
+  // The free slots up to the end of the buffer.  Fill some, then commit
+  // them.
+  Span write_span() {
+    auto const head = _head.load(std::memory_order_relaxed);
+    auto const tail = _tail.load(std::memory_order_acquire);
+    auto const start = head & mask;
+    auto const free = N - (head - tail);
+    return { &_elements[start], min(free, N - start) };
+  }
+
+  // Publishes 'count' elements written to the front of write_span().
+  void commit(unsigned count) {
+    _head.store(_head.load(std::memory_order_relaxed) + count,
+                std::memory_order_release);
+  }
+
+  bool push(T const & value) {
+    auto const span = write_span();
+    if (span.count == 0) return false;
+    span.data[0] = value;
+    commit(1);
+    return true;
+  }
+
+  // Copies in as many of 'count' elements as fit, and returns how many.
+  unsigned write(T const * values, unsigned count) {
+    unsigned done = 0;
+    // At most two spans: up to the end of the buffer, and from its start.
+    for (unsigned pass = 0; pass < 2 && done < count; ++pass) {
+      auto const span = write_span();
+      auto const n = min(span.count, count - done);
+      if (n == 0) break;
+      for (unsigned i = 0; i < n; ++i) span.data[i] = values[done + i];
+      commit(n);
+      done += n;
+    }
+    return done;
+  }
+
+  /*
+   * Consumer side.
+   */
+
+  // The filled slots up to the end of the buffer.  Use some, then release
+  // them.
+  Span read_span() {
+    auto const tail = _tail.load(std::memory_order_relaxed);
+    auto const head = _head.load(std::memory_order_acquire);
+    auto const start = tail & mask;
+    return { &_elements[start], min(head - tail, N - start) };
+  }
+
+  // Frees 'count' elements from the front of read_span().
+  void release(unsigned count) {
+    _tail.store(_tail.load(std::memory_order_relaxed) + count,
+                std::memory_order_release);
+  }
+
+  bool pop(T & value) {
+    auto const span = read_span();
+    if (span.count == 0) return false;
+    value = span.data[0];
+    release(1);
+    return true;
+  }
+
+  // Copies out up to 'count' elements, and returns how many.
+  unsigned read(T * values, unsigned count) {
+    unsigned done = 0;
+    for (unsigned pass = 0; pass < 2 && done < count; ++pass) {
+      auto const span = read_span();
+      auto const n = min(span.count, count - done);
+      if (n == 0) break;
+      for (unsigned i = 0; i < n; ++i) values[done + i] = span.data[i];
+      release(n);
+      done += n;
+    }
+    return done;
+  }
+
+  /*
+   * Either side.  These are snapshots, and may be stale by the time they're
+   * used -- but only in the safe direction for the side asking.
+   */
+
+  unsigned size() const {
+    return _head.load(std::memory_order_acquire)
+         - _tail.load(std::memory_order_acquire);
+  }
+
+  bool is_empty() const { return size() == 0; }
+  bool is_full() const { return size() == N; }
+
+private:
+  static constexpr unsigned mask = N - 1;
+
+  static unsigned min(unsigned a, unsigned b) { return a < b ? a : b; }
+
+  // Counts of elements ever written and read.  They wrap around freely;
+  // only their difference, and their low bits, matter.
+  std::atomic<unsigned> _head;
+  std::atomic<unsigned> _tail;
+
+  T _elements[N];
+};
+
+}  // namespace demo
+
+#endif  // DEMO_SPSC_RING_H
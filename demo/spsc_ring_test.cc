@@ -0,0 +1,184 @@
+/*
+ * Host test and benchmark for SpscRing.
+ *
+ * A producer thread writes a numbered sequence through the ring while the
+ * consumer, on the main thread, checks that it comes out whole and in order.
+ * Both sides mix single elements, bulk copies and spans, with chunk sizes
+ * that don't divide the ring, so the wrap is hit at every offset.  Run on a
+ * multicore host this exercises the acquire/release ordering too; on one
+ * core it still checks the index arithmetic.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "demo/spsc_ring.h"
+
+using demo::SpscRing;
+
+// Checks the single-threaded basics: empty and full, and each side's
+// spans around the wrap.
+static unsigned test_basics() {
+  unsigned failures = 0;
+  auto check = [&failures](bool ok, char const * what) {
+    if (!ok) {
+      std::printf("FAIL: %s\n", what);
+      ++failures;
+    }
+  };
+
+  static SpscRing<unsigned, 8> ring;
+  unsigned value;
+  check(ring.is_empty(), "new ring is empty");
+  check(!ring.pop(value), "pop from empty ring");
+
+  for (unsigned i = 0; i < 8; ++i) check(ring.push(i), "push to non-full ring");
+  check(ring.is_full(), "ring is full after capacity pushes");
+  check(!ring.push(8), "push to full ring");
+  check(ring.write_span().count == 0, "full ring has no write span");
+
+  unsigned out[8];
+  check(ring.read(out, 5) == 5, "read 5 of 8");
+  check(out[0] == 0 && out[4] == 4, "read values");
+
+  // Five slots free, but only the first three are contiguous at the end.
+  unsigned in[] { 8, 9, 10, 11, 12, 13 };
+  check(ring.write_span().count == 5, "write span after partial read");
+  check(ring.write(in, 6) == 5, "write wraps and stops when full");
+  check(ring.read_span().count == 3, "read span stops at end of buffer");
+  check(ring.read(out, 8) == 8, "read wraps");
+  for (unsigned i = 0; i < 8; ++i) check(out[i] == 5 + i, "wrapped values");
+  check(ring.is_empty(), "ring is empty after reading everything");
+  return failures;
+}
+
+/*
+ * Sends 'total' numbered elements from a producer thread to this one through
+ * a ring of N, returning the number that arrived wrong, or out of order.
+ * The sides use single elements, spans or bulk copies in rotation.
+ */
+template <unsigned N>
+static unsigned stress(unsigned total) {
+  static SpscRing<unsigned, N> ring;
+
+  std::thread producer([total] {
+    unsigned next = 0;
+    unsigned buffer[37];
+    for (unsigned round = 0; next < total; ++round) {
+      unsigned n = 0;
+      switch (round % 3) {
+        case 0:
+          n = ring.push(next) ? 1 : 0;
+          break;
+
+        case 1: {
+          auto const span = ring.write_span();
+          while (n < span.count && next + n < total) {
+            span.data[n] = next + n;
+            ++n;
+          }
+          ring.commit(n);
+          break;
+        }
+
+        default: {
+          unsigned count = 0;
+          while (count < 37 && next + count < total) {
+            buffer[count] = next + count;
+            ++count;
+          }
+          n = ring.write(buffer, count);
+          break;
+        }
+      }
+      next += n;
+      if (n == 0) std::this_thread::yield();
+    }
+  });
+
+  unsigned expected = 0, bad = 0;
+  unsigned buffer[53];
+  for (unsigned round = 0; expected < total; ++round) {
+    unsigned n = 0;
+    switch (round % 3) {
+      case 0:
+        if (ring.pop(buffer[0])) n = 1;
+        bad += n && buffer[0] != expected;
+        break;
+
+      case 1: {
+        auto const span = ring.read_span();
+        n = span.count;
+        for (unsigned i = 0; i < n; ++i) bad += span.data[i] != expected + i;
+        ring.release(n);
+        break;
+      }
+
+      default:
+        n = ring.read(buffer, 53);
+        for (unsigned i = 0; i < n; ++i) bad += buffer[i] != expected + i;
+        break;
+    }
+    expected += n;
+    if (n == 0) std::this_thread::yield();
+  }
+
+  producer.join();
+  return bad;
+}
+
+/*
+ * Measures throughput with bulk reads and writes of 'chunk' elements at a
+ * time through a ring of N, in millions of elements per second.
+ */
+template <unsigned N>
+static double benchmark(unsigned total, unsigned chunk) {
+  static SpscRing<unsigned, N> ring;
+  static unsigned in[256], out[256];
+
+  auto const start = std::chrono::steady_clock::now();
+  std::thread producer([total, chunk] {
+    for (unsigned sent = 0; sent < total; ) {
+      auto const n = ring.write(in, chunk < total - sent ? chunk
+                                                         : total - sent);
+      if (n == 0) std::this_thread::yield();
+      sent += n;
+    }
+  });
+  for (unsigned received = 0; received < total; ) {
+    auto const n = ring.read(out, chunk);
+    if (n == 0) std::this_thread::yield();
+    received += n;
+  }
+  producer.join();
+
+  auto const seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  return total / seconds / 1e6;
+}
+
+int main() {
+  auto failures = test_basics();
+
+  auto const small = stress<16>(500000);
+  auto const large = stress<1024>(2000000);
+  if (small || large) {
+    std::printf("FAIL: %u bad elements through 16-element ring, "
+                "%u through 1024-element ring\n", small, large);
+    ++failures;
+  }
+
+  if (failures) {
+    std::printf("%u failures\n", failures);
+    return 1;
+  }
+  std::printf("All tests passed.\n");
+
+  static unsigned const chunks[] { 1, 16, 256 };
+  for (auto chunk : chunks) {
+    std::printf("%3u-element chunks: %.1f million elements per second\n",
+                chunk, benchmark<1024>(10000000, chunk));
+  }
+  return 0;
+}
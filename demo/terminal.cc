@@ -1,50 +1,137 @@
 #include "demo/terminal.h"
 
+#include "etl/assert.h"
+#include "etl/attribute_macros.h"
+
+#ifndef BUILDING_ON_HOST
 #include "vga/font_10x16.h"
+#endif
 
 namespace demo {
 
+/*******************************************************************************
+ * ScrollingText
+ */
+
+ScrollingText::ScrollingText(unsigned char const * font,
+                             unsigned glyph_count,
+                             unsigned width,
+                             unsigned height,
+                             unsigned top_line)
+  : Text_10x16(font, glyph_count, width, height, top_line),
+    _top_line(top_line) {
+  ETL_ASSERT(get_row_count() <= max_rows);
+  reset_rows();
+}
+
+void ScrollingText::reset_rows() {
+  for (unsigned row = 0; row < max_rows; ++row) {
+    _row_map[row] = row;
+  }
+}
+
+unsigned ScrollingText::rotate_rows_up(unsigned top, unsigned bottom) {
+  auto const first = _row_map[top];
+  for (unsigned row = top; row < bottom; ++row) {
+    _row_map[row] = _row_map[row + 1];
+  }
+  _row_map[bottom] = first;
+  return first;
+}
+
+unsigned ScrollingText::rotate_rows_down(unsigned top, unsigned bottom) {
+  auto const last = _row_map[bottom];
+  for (unsigned row = bottom; row > top; --row) {
+    _row_map[row] = _row_map[row - 1];
+  }
+  _row_map[top] = last;
+  return last;
+}
+
+void ScrollingText::set_top_line(unsigned line) {
+  _top_line = line;
+  Text_10x16::set_top_line(line);
+}
+
+ETL_SECTION(".ramcode")
+auto ScrollingText::rasterize(unsigned cycles_per_pixel,
+                              unsigned line_number,
+                              Pixel *target) -> RasterInfo {
+  auto const line = line_number - _top_line;
+  auto const row = line / glyph_rows;
+
+  // Lines past the last full row are left to Text_10x16.
+  if (row < get_row_count()) {
+    line_number = _top_line + _row_map[row] * glyph_rows + line % glyph_rows;
+  }
+
+  return Text_10x16::rasterize(cycles_per_pixel, line_number, target);
+}
+
+/*******************************************************************************
+ * Terminal
+ */
+
 Terminal::Terminal(unsigned width, unsigned height, unsigned top_line)
   : rasterizer(vga::font_10x16, 256, width, height, top_line),
-    t_row(0), t_col(0) {
+    t_row(0), t_col(0),
+    _wrap_pending(false),
+    _clear_color(0),
+    _dirty_rows(0),
+    _scroll_top(0),
+    _scroll_bottom(rasterizer.get_row_count() - 1) {
   rasterizer.clear_framebuffer(0);
 }
 
+void Terminal::put(Pixel fore, Pixel back, char c) {
+  auto const row = rasterizer.framebuffer_row(t_row);
+  rasterizer.put_char(t_col, row, fore, back, c);
+  _dirty_rows |= std::uint64_t(1) << row;
+}
+
+void Terminal::wrap(Pixel back) {
+  _wrap_pending = false;
+  t_col = 0;
+  line_feed(back);
+}
+
 void Terminal::type_raw(Pixel fore, Pixel back, char c) {
-  rasterizer.put_char(t_col, t_row, fore, back, c);
-  ++t_col;
-  if (t_col == rasterizer.get_col_count()) {
-    t_col = 0;
-    ++t_row;
-    if (t_row == rasterizer.get_row_count()) t_row = 0;
+  if (_wrap_pending) wrap(back);
+
+  put(fore, back, c);
+
+  if (t_col + 1 == rasterizer.get_col_count()) {
+    _wrap_pending = true;
+  } else {
+    ++t_col;
   }
 }
 
 void Terminal::type(Pixel fore, Pixel back, char c) {
   switch (c) {
     case '\r':
-      do {
-        type_raw(fore, back, ' ');
-      } while (t_col);
-      return;
-
     case '\n':
-      do {
-        type_raw(fore, back, ' ');
-      } while (t_col);
+      // Paint out the rest of the line in the background color, then start
+      // a new one.
+      while (!_wrap_pending) type_raw(fore, back, ' ');
+      wrap(back);
       return;
 
     case '\f':
-      rasterizer.clear_framebuffer(back);
+      clear(back);
       cursor_to(0, 0);
       return;
 
     case '\b':
-      if (t_col) {
-        --t_col;
-        type_raw(fore, back, ' ');
+      if (_wrap_pending) {
+        // The cursor is still on the last character typed.
+        _wrap_pending = false;
+      } else if (t_col) {
         --t_col;
+      } else {
+        return;
       }
+      put(fore, back, ' ');
       return;
 
     default:
@@ -53,6 +140,34 @@ void Terminal::type(Pixel fore, Pixel back, char c) {
   }
 }
 
+void Terminal::type_run(Pixel fore, Pixel back,
+                        char const *s, unsigned count) {
+  auto const cols = rasterizer.get_col_count();
+  auto const attributes = (unsigned(fore) << 16) | (unsigned(back) << 8);
+
+  while (count) {
+    if (_wrap_pending) wrap(back);
+
+    // Fill as much of the current row as the run covers.
+    auto const row = rasterizer.framebuffer_row(t_row);
+    auto const n = count < cols - t_col ? count : cols - t_col;
+    for (unsigned i = 0; i < n; ++i) {
+      rasterizer.put_packed(t_col + i, row,
+                            attributes | static_cast<unsigned char>(s[i]));
+    }
+    _dirty_rows |= std::uint64_t(1) << row;
+
+    s += n;
+    count -= n;
+    if (t_col + n == cols) {
+      t_col = cols - 1;
+      _wrap_pending = true;
+    } else {
+      t_col += n;
+    }
+  }
+}
+
 void Terminal::type(Pixel fore, Pixel back, char const *s) {
   while (char c = *s++) {
     type(fore, back, c);
@@ -65,6 +180,7 @@ void Terminal::cursor_to(unsigned col, unsigned row) {
 
   t_col = col;
   t_row = row;
+  _wrap_pending = false;
 }
 
 void Terminal::text_at(unsigned col, unsigned row,
@@ -98,5 +214,96 @@ void Terminal::rainbow_type(char const *s) {
   }
 }
 
+void Terminal::line_feed(Pixel back) {
+  _wrap_pending = false;
+  if (t_row == _scroll_bottom) {
+    scroll(back);
+  } else if (t_row + 1 < rasterizer.get_row_count()) {
+    ++t_row;
+  }
+}
+
+void Terminal::reverse_line_feed(Pixel back) {
+  _wrap_pending = false;
+  if (t_row == _scroll_top) {
+    scroll_down(_scroll_top, _scroll_bottom, back);
+  } else if (t_row) {
+    --t_row;
+  }
+}
+
+void Terminal::set_scroll_region(unsigned top, unsigned bottom) {
+  if (top < bottom && bottom < rasterizer.get_row_count()) {
+    _scroll_top = top;
+    _scroll_bottom = bottom;
+  }
+}
+
+void Terminal::scroll(Pixel back) {
+  scroll_up(_scroll_top, _scroll_bottom, back);
+}
+
+void Terminal::scroll_up(unsigned top, unsigned bottom, Pixel back) {
+  // The top row's framebuffer row is reused for the bottom once it's blank.
+  clear_row(rasterizer.framebuffer_row(top), back);
+  rasterizer.rotate_rows_up(top, bottom);
+}
+
+void Terminal::scroll_down(unsigned top, unsigned bottom, Pixel back) {
+  clear_row(rasterizer.framebuffer_row(bottom), back);
+  rasterizer.rotate_rows_down(top, bottom);
+}
+
+void Terminal::clear(Pixel back) {
+  auto const rows = rasterizer.get_row_count();
+  auto const all_rows =
+      ~std::uint64_t(0) >> (ScrollingText::max_rows - rows);
+
+  if (back != _clear_color || _dirty_rows == all_rows) {
+    rasterizer.clear_framebuffer(back);
+    _clear_color = back;
+    _dirty_rows = 0;
+  } else {
+    for (unsigned row = 0; row < rows; ++row) {
+      clear_row(row, back);
+    }
+  }
+
+  rasterizer.reset_rows();
+}
+
+void Terminal::erase(unsigned row,
+                     unsigned from_col,
+                     unsigned to_col,
+                     Pixel back) {
+  auto const cols = rasterizer.get_col_count();
+  if (to_col > cols) to_col = cols;
+  if (from_col >= to_col) return;
+
+  auto const fb_row = rasterizer.framebuffer_row(row);
+  if (from_col == 0 && to_col == cols) {
+    clear_row(fb_row, back);
+    return;
+  }
+
+  for (unsigned col = from_col; col < to_col; ++col) {
+    rasterizer.put_char(col, fb_row, back, back, ' ');
+  }
+  _dirty_rows |= std::uint64_t(1) << fb_row;
+}
+
+void Terminal::clear_row(unsigned row, Pixel back) {
+  auto const bit = std::uint64_t(1) << row;
+  if (back == _clear_color) {
+    if ((_dirty_rows & bit) == 0) return;
+    _dirty_rows &= ~bit;
+  } else {
+    _dirty_rows |= bit;
+  }
+
+  for (unsigned col = 0; col < rasterizer.get_col_count(); ++col) {
+    rasterizer.put_char(col, row, back, back, ' ');
+  }
+}
 
 }  // namespace demo
@@ -1,8 +1,16 @@
 #ifndef DEMO_TERMINAL_H
 #define DEMO_TERMINAL_H
 
+#include <cstdint>
+
+// Host tests use a mock of the rasterizer, which keeps the text where they
+// can check it.
+#ifdef BUILDING_ON_HOST
+#include "demo/mock_text_10x16.h"
+#else
 #include "vga/rast/text_10x16.h"
 #include "vga/rasterizer.h"
+#endif
 
 namespace demo {
 
@@ -21,15 +29,64 @@ enum {
   blue    = 0b110000,
 };
 
+/*
+ * A Text_10x16 that can show its framebuffer rows in any order, through a
+ * map from screen rows to framebuffer rows.  Rotating part of the map
+ * scrolls that part of the screen without moving any characters.
+ *
+ * Rows given to put_char and friends are framebuffer rows, not screen rows.
+ */
+class ScrollingText : public vga::rast::Text_10x16 {
+public:
+  static constexpr unsigned glyph_rows = 16;
+  static constexpr unsigned max_rows = 64;
+
+  ScrollingText(unsigned char const * font,
+                unsigned glyph_count,
+                unsigned width,
+                unsigned height,
+                unsigned top_line = 0);
+
+  RasterInfo rasterize(unsigned, unsigned, Pixel *) override;
+
+  // Replaces Text_10x16's version, which this needs to keep track of.
+  void set_top_line(unsigned);
+
+  // The framebuffer row shown on the given screen row.
+  unsigned framebuffer_row(unsigned row) const { return _row_map[row]; }
+
+  // Shows each framebuffer row on the screen row of the same number.
+  void reset_rows();
+
+  // Moves the framebuffer rows shown on screen rows top+1 through bottom up
+  // one, and shows the one from the top on the bottom row.  Returns that
+  // framebuffer row.
+  unsigned rotate_rows_up(unsigned top, unsigned bottom);
+
+  // The reverse: moves rows top through bottom-1 down one, and shows the
+  // one from the bottom on the top row, returning it.
+  unsigned rotate_rows_down(unsigned top, unsigned bottom);
+
+private:
+  unsigned _top_line;
+  std::uint8_t _row_map[max_rows];
+};
+
 struct Terminal {
   using Pixel = vga::Rasterizer::Pixel;
 
-  vga::rast::Text_10x16 rasterizer;
+  ScrollingText rasterizer;
 
   unsigned t_row, t_col;
 
   Terminal(unsigned width, unsigned height, unsigned top_line = 0);
 
+  /*
+   * Types a character at the cursor, without interpreting control
+   * characters.  After the last column, the cursor stays put until the next
+   * character arrives, which starts a new line -- scrolling if the cursor is
+   * on the bottom row.  So filling the bottom row doesn't scroll by itself.
+   */
   void type_raw(Pixel fore, Pixel back, char c);
 
   void type(Pixel fore, Pixel back, char c);
@@ -45,6 +102,59 @@ struct Terminal {
   void text_centered(unsigned row, Pixel fore, Pixel back, char const *s);
 
   void rainbow_type(char const *);
+
+  /*
+   * Types a run of characters in one color, without interpreting control
+   * characters.  This is equivalent to calling type_raw for each, but
+   * cheaper.
+   */
+  void type_run(Pixel fore, Pixel back, char const *s, unsigned count);
+
+  // Moves the cursor down a row, scrolling the scroll region up if the
+  // cursor is on its bottom row.
+  void line_feed(Pixel back);
+
+  // Moves the cursor up a row, scrolling the scroll region down if the
+  // cursor is on its top row.
+  void reverse_line_feed(Pixel back);
+
+  // Limits scrolling to rows top through bottom, inclusive.  Invalid regions
+  // are ignored.
+  void set_scroll_region(unsigned top, unsigned bottom);
+  unsigned get_scroll_top() const { return _scroll_top; }
+  unsigned get_scroll_bottom() const { return _scroll_bottom; }
+
+  // Moves the text in the scroll region up a row, leaving a blank row at the
+  // bottom.  The cursor doesn't move.
+  void scroll(Pixel back);
+
+  // Moves the text in rows top through bottom, inclusive, up or down a row,
+  // leaving a blank row behind.  The cursor doesn't move.
+  void scroll_up(unsigned top, unsigned bottom, Pixel back);
+  void scroll_down(unsigned top, unsigned bottom, Pixel back);
+
+  // Blanks the screen to the given color.  The cursor doesn't move.
+  void clear(Pixel back);
+
+  // Blanks columns from_col up to (not including) to_col of a row.
+  void erase(unsigned row, unsigned from_col, unsigned to_col, Pixel back);
+
+private:
+  // Set when a character has been typed in the last column, and the next
+  // one should start a new line.
+  bool _wrap_pending;
+
+  // The color the screen was last cleared to, and a bit for each
+  // framebuffer row that has been written since.  Clean rows don't need
+  // clearing again in that color.
+  Pixel _clear_color;
+  std::uint64_t _dirty_rows;
+
+  unsigned _scroll_top, _scroll_bottom;
+
+  void put(Pixel fore, Pixel back, char c);
+  void wrap(Pixel back);
+  void clear_row(unsigned row, Pixel back);
 };
 
 }  // namespace demo
@@ -0,0 +1,398 @@
+/*
+ * Host test for Terminal, on a mock Text_10x16 that keeps the characters
+ * where they can be checked.
+ *
+ * The first tests pin down the details: wrapping only when the character
+ * after the last column arrives, backspace, scrolling through the row map,
+ * and clear() leaving alone the rows that are already clear.  The last one
+ * runs random operations against a simple model of the screen, which moves
+ * characters around the way the row map avoids doing, and checks that the
+ * two always show the same thing -- that skipping clean rows never leaves
+ * stale text behind.
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "demo/terminal.h"
+
+using demo::Terminal;
+using Pixel = Terminal::Pixel;
+
+// A small screen, so expected rows are easy to write out: 10 columns, 4 rows.
+static constexpr unsigned width = 100, height = 64, cols = 10, rows = 4;
+
+static unsigned failures;
+
+static void fail(char const * test, char const * what) {
+  std::printf("FAIL: %s: %s\n", test, what);
+  ++failures;
+}
+
+static void expect(bool ok, char const * test, char const * what) {
+  if (!ok) fail(test, what);
+}
+
+// The characters shown on a screen row.
+static std::string screen_row(Terminal const & t, unsigned row) {
+  auto const fb_row = t.rasterizer.framebuffer_row(row);
+  std::string s;
+  for (unsigned col = 0; col < cols; ++col) {
+    s += t.rasterizer.char_at(col, fb_row);
+  }
+  return s;
+}
+
+static void expect_row(Terminal const & t, unsigned row, char const * text,
+                       char const * test) {
+  auto const got = screen_row(t, row);
+  if (got != text) {
+    std::printf("FAIL: %s: row %u is \"%s\", expected \"%s\"\n",
+                test, row, got.c_str(), text);
+    ++failures;
+  }
+}
+
+static void expect_cursor(Terminal const & t, unsigned col, unsigned row,
+                          char const * test) {
+  if (t.t_col != col || t.t_row != row) {
+    std::printf("FAIL: %s: cursor at %u,%u, expected %u,%u\n",
+                test, t.t_col, t.t_row, col, row);
+    ++failures;
+  }
+}
+
+static void test_pending_wrap() {
+  static constexpr char const * test = "pending wrap";
+  Terminal t(width, height);
+
+  t.type(1, 0, "0123456789");
+  expect_cursor(t, 9, 0, test);
+  t.type(1, 0, 'a');
+  expect_row(t, 0, "0123456789", test);
+  expect_row(t, 1, "a         ", test);
+  expect_cursor(t, 1, 1, test);
+
+  // Filling the bottom row leaves the screen alone until the next
+  // character, which scrolls.
+  t.cursor_to(0, rows - 1);
+  t.type_run(1, 0, "ABCDEFGHIJ", cols);
+  expect_row(t, 0, "0123456789", test);
+  expect_row(t, 3, "ABCDEFGHIJ", test);
+  expect_cursor(t, 9, 3, test);
+  t.type_raw(1, 0, 'K');
+  expect_row(t, 0, "a         ", test);
+  expect_row(t, 2, "ABCDEFGHIJ", test);
+  expect_row(t, 3, "K         ", test);
+  expect_cursor(t, 1, 3, test);
+
+  // Moving the cursor cancels the wrap.
+  t.cursor_to(0, 0);
+  t.type(1, 0, "0123456789");
+  t.cursor_to(5, 1);
+  t.type(1, 0, 'x');
+  expect_row(t, 1, "     x    ", test);
+}
+
+static void test_backspace() {
+  static constexpr char const * test = "backspace";
+  Terminal t(width, height);
+
+  t.type(1, 0, "ab\b");
+  expect_row(t, 0, "a         ", test);
+  expect_cursor(t, 1, 0, test);
+
+  // With a wrap pending, the cursor is still on the last column, so that's
+  // the character erased.
+  t.cursor_to(0, 1);
+  t.type(1, 0, "0123456789\b");
+  expect_row(t, 1, "012345678 ", test);
+  expect_cursor(t, 9, 1, test);
+  t.type(1, 0, 'x');
+  expect_row(t, 1, "012345678x", test);
+  expect_row(t, 2, "          ", test);
+
+  // Nothing happens in the first column.
+  t.cursor_to(0, 3);
+  t.type(1, 0, 'z');
+  t.cursor_to(0, 3);
+  t.type(1, 0, '\b');
+  expect_row(t, 3, "z         ", test);
+  expect_cursor(t, 0, 3, test);
+}
+
+static void test_scroll() {
+  static constexpr char const * test = "scroll";
+  Terminal t(width, height, 8);
+
+  t.type(1, 0, "r0\nr1\nr2\nr3");
+  auto const writes = t.rasterizer.cell_writes;
+  t.scroll(0);
+  expect_row(t, 0, "r1        ", test);
+  expect_row(t, 2, "r3        ", test);
+  expect_row(t, 3, "          ", test);
+  expect_cursor(t, 2, 3, test);
+  expect(t.rasterizer.cell_writes - writes == cols, test,
+         "scrolling should only blank the new row");
+
+  // Scanlines come from the framebuffer row shown on the screen row.
+  auto const line = 8 + 1 * 16 + 5;
+  t.rasterizer.rasterize(4, line, nullptr);
+  expect(t.rasterizer.last_line
+           == 8 + t.rasterizer.framebuffer_row(1) * 16 + 5,
+         test, "rasterize should map lines through the row map");
+
+  // Only the scroll region moves.
+  t.set_scroll_region(1, 2);
+  t.cursor_to(0, 2);
+  t.line_feed(0);
+  expect_row(t, 0, "r1        ", test);
+  expect_row(t, 1, "r3        ", test);
+  expect_row(t, 2, "          ", test);
+  expect_row(t, 3, "          ", test);
+  expect_cursor(t, 0, 2, test);
+
+  t.cursor_to(0, 1);
+  t.reverse_line_feed(0);
+  expect_row(t, 0, "r1        ", test);
+  expect_row(t, 1, "          ", test);
+  expect_row(t, 2, "r3        ", test);
+  expect_cursor(t, 0, 1, test);
+
+  t.scroll_down(0, 3, 0);
+  expect_row(t, 0, "          ", test);
+  expect_row(t, 1, "r1        ", test);
+  expect_row(t, 3, "r3        ", test);
+
+  // A region that doesn't fit is ignored.
+  t.set_scroll_region(2, rows);
+  expect(t.get_scroll_top() == 1 && t.get_scroll_bottom() == 2,
+         test, "invalid scroll region should be ignored");
+}
+
+static void test_clear() {
+  static constexpr char const * test = "clear";
+  Terminal t(width, height);
+  auto & r = t.rasterizer;
+
+  // Only the row written is cleared again.
+  t.text_at(0, 1, 1, 0, "hello");
+  auto writes = r.cell_writes;
+  auto clears = r.framebuffer_clears;
+  t.clear(0);
+  expect(r.cell_writes - writes == cols && r.framebuffer_clears == clears,
+         test, "clear should touch only the dirty row");
+  expect_row(t, 1, "          ", test);
+
+  // Clearing a clear screen does nothing.
+  writes = r.cell_writes;
+  t.clear(0);
+  expect(r.cell_writes == writes && r.framebuffer_clears == clears,
+         test, "clear of a clear screen should touch nothing");
+
+  // A new color needs the whole framebuffer.
+  t.clear(2);
+  expect(r.cell_writes == writes && r.framebuffer_clears == clears + 1,
+         test, "clear to a new color should clear the framebuffer");
+  expect(r.back_at(3, 2) == 2, test, "clear should use the new color");
+
+  // So does a screen that's dirty all over.
+  for (unsigned row = 0; row < rows; ++row) t.text_at(0, row, 1, 2, "x");
+  writes = r.cell_writes;
+  t.clear(2);
+  expect(r.cell_writes == writes && r.framebuffer_clears == clears + 2,
+         test, "clear of a dirty screen should clear the framebuffer");
+
+  // Erasing a whole row in another color leaves it dirty for the next
+  // clear.
+  t.erase(0, 0, cols, 3);
+  t.erase(1, 2, 5, 3);
+  writes = r.cell_writes;
+  t.clear(2);
+  expect(r.cell_writes - writes == 2 * cols, test,
+         "clear should redo rows erased in another color");
+  expect(r.back_at(0, 0) == 2 && r.back_at(3, 1) == 2, test,
+         "clear should leave no other color behind");
+}
+
+/*
+ * A model of the screen that works the obvious way, for comparison.
+ */
+struct Cell {
+  char c;
+  Pixel fore, back;
+
+  bool operator!=(Cell const & o) const {
+    return c != o.c || fore != o.fore || back != o.back;
+  }
+};
+
+struct Model {
+  std::vector<std::vector<Cell>> cells;
+  unsigned row, col;
+  bool wrap_pending;
+  unsigned top, bottom;
+
+  Model()
+    : cells(rows, std::vector<Cell>(cols, Cell{' ', 0, 0})),
+      row(0), col(0), wrap_pending(false), top(0), bottom(rows - 1) {}
+
+  void blank(unsigned r, Pixel back) {
+    for (auto & cell : cells[r]) cell = Cell{' ', back, back};
+  }
+
+  void scroll_up(unsigned t, unsigned b, Pixel back) {
+    for (unsigned r = t; r < b; ++r) cells[r] = cells[r + 1];
+    blank(b, back);
+  }
+
+  void scroll_down(unsigned t, unsigned b, Pixel back) {
+    for (unsigned r = b; r > t; --r) cells[r] = cells[r - 1];
+    blank(t, back);
+  }
+
+  void line_feed(Pixel back) {
+    wrap_pending = false;
+    if (row == bottom) {
+      scroll_up(top, bottom, back);
+    } else if (row + 1 < rows) {
+      ++row;
+    }
+  }
+
+  void type_raw(Pixel fore, Pixel back, char c) {
+    if (wrap_pending) {
+      col = 0;
+      line_feed(back);
+    }
+    cells[row][col] = Cell{c, fore, back};
+    if (col + 1 == cols) {
+      wrap_pending = true;
+    } else {
+      ++col;
+    }
+  }
+};
+
+static void test_against_model() {
+  static constexpr char const * test = "model";
+  std::mt19937 rng(1);
+  Terminal t(width, height);
+  Model m;
+
+  for (unsigned step = 0; step < 200000 && !failures; ++step) {
+    Pixel const fore = Pixel(rng() % 4), back = Pixel(rng() % 3);
+    switch (rng() % 10) {
+      case 0:
+        t.clear(back);
+        for (unsigned r = 0; r < rows; ++r) m.blank(r, back);
+        break;
+
+      case 1: {
+        auto const r = unsigned(rng() % rows);
+        auto const from = unsigned(rng() % (cols + 1));
+        auto const to = unsigned(rng() % (cols + 2));
+        t.erase(r, from, to, back);
+        for (unsigned c = from; c < to && c < cols; ++c) {
+          m.cells[r][c] = Cell{' ', back, back};
+        }
+        break;
+      }
+
+      case 2: {
+        auto const a = unsigned(rng() % rows), b = unsigned(rng() % rows);
+        if (a < b) {
+          if (rng() % 2) {
+            t.scroll_up(a, b, back);
+            m.scroll_up(a, b, back);
+          } else {
+            t.scroll_down(a, b, back);
+            m.scroll_down(a, b, back);
+          }
+        }
+        break;
+      }
+
+      case 3: {
+        auto const a = unsigned(rng() % rows), b = unsigned(rng() % rows);
+        t.set_scroll_region(a, b);
+        if (a < b) {
+          m.top = a;
+          m.bottom = b;
+        }
+        break;
+      }
+
+      case 4: {
+        auto const c = unsigned(rng() % cols), r = unsigned(rng() % rows);
+        t.cursor_to(c, r);
+        m.col = c;
+        m.row = r;
+        m.wrap_pending = false;
+        break;
+      }
+
+      case 5:
+        t.line_feed(back);
+        m.line_feed(back);
+        break;
+
+      case 6: {
+        char run[2 * cols];
+        auto const n = unsigned(rng() % sizeof(run));
+        for (unsigned i = 0; i < n; ++i) {
+          run[i] = char('a' + rng() % 26);
+          m.type_raw(fore, back, run[i]);
+        }
+        t.type_run(fore, back, run, n);
+        break;
+      }
+
+      default: {
+        auto const c = char('A' + rng() % 26);
+        t.type_raw(fore, back, c);
+        m.type_raw(fore, back, c);
+        break;
+      }
+    }
+
+    if (t.t_col != m.col || t.t_row != m.row) {
+      std::printf("FAIL: %s: step %u: cursor at %u,%u, expected %u,%u\n",
+                  test, step, t.t_col, t.t_row, m.col, m.row);
+      ++failures;
+    }
+    for (unsigned r = 0; r < rows; ++r) {
+      auto const fb_row = t.rasterizer.framebuffer_row(r);
+      for (unsigned c = 0; c < cols; ++c) {
+        Cell const got {
+          t.rasterizer.char_at(c, fb_row),
+          t.rasterizer.fore_at(c, fb_row),
+          t.rasterizer.back_at(c, fb_row),
+        };
+        if (got != m.cells[r][c]) {
+          std::printf("FAIL: %s: step %u: cell %u,%u differs\n",
+                      test, step, c, r);
+          ++failures;
+          return;
+        }
+      }
+    }
+  }
+}
+
+int main() {
+  test_pending_wrap();
+  test_backspace();
+  test_scroll();
+  test_clear();
+  test_against_model();
+
+  if (failures) {
+    std::printf("%u failures\n", failures);
+    return 1;
+  }
+  std::printf("All tests passed.\n");
+  return 0;
+}
@@ -18,6 +18,13 @@ static constexpr char message[82] =
   "h and resolution  - "
   " ";
 
+Wipe::Wipe() {
+  for (unsigned i = 0; i < 81; ++i) {
+    _message[i] = (demo::white << 16) | (demo::black << 8)
+                | static_cast<unsigned char>(message[i]);
+  }
+}
+
 void Wipe::configure_band_list() {
   vga::configure_band_list(_bands);
 }
@@ -31,23 +38,12 @@ bool Wipe::render_frame(unsigned frame) {
   auto split = config::rows/2 +
       std::sin(float(frame) / 127) * (config::rows/4);
 
-  auto scroll = frame * 2;
-
   _bands[0].line_count = split - center_height/2;
   _bands[1].line_count = center_height;
   _bands[2].line_count = config::rows - (split + center_height/2);
 
   _term.rasterizer.set_top_line(split - config::max_band_height/2);
-  _term.rasterizer.set_x_adj(-(scroll % 10));
-
-  unsigned x = (scroll / 10) % 81;
-  _term.cursor_to(0, 1);
-  for (unsigned i = 0; i < 81 - x; ++i) {
-    _term.type_raw(demo::white, demo::black, message[x + i]);
-  }
-  for (unsigned i = 0; i < x; ++i) {
-    _term.type_raw(demo::white, demo::black, message[i]);
-  }
+  _marquee.scroll_to(frame * 2);
 
   return continuing;
 }
@@ -3,6 +3,7 @@
 
 #include "vga/vga.h"
 
+#include "demo/marquee.h"
 #include "demo/terminal.h"
 #include "demo/scene.h"
 #include "demo/xor_pattern/rasterizer.h"
@@ -17,6 +18,8 @@ namespace wipe {
  */
 class Wipe : public Scene {
 public:
+  Wipe();
+
   void configure_band_list() override;
   bool render_frame(unsigned) override;
 
@@ -25,6 +28,10 @@ private:
   demo::Terminal _term{config::cols + 10,
                        config::max_band_height,
                        config::rows/2 - config::max_band_height/2};
+  // The scrolling message, packed for the marquee.
+  unsigned _message[81];
+  Marquee _marquee{_term.rasterizer, 1, _message, 81};
+
   vga::Band _bands[3] {
     { &_border,          config::rows/2, &_bands[1] },
     { &_term.rasterizer, 0,              &_bands[2] },
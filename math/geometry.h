@@ -5,7 +5,15 @@
 
 namespace math {
 
-using Vec3h = etl::math::Vec3<__fp16>;
+// Half-precision floats.  x86 compilers lack __fp16, so host builds use
+// _Float16, which has the same IEEE format.
+#ifdef BUILDING_ON_HOST
+using Half = _Float16;
+#else
+using Half = __fp16;
+#endif
+
+using Vec3h = etl::math::Vec3<Half>;
 
 }  // namespace math
 
@@ -0,0 +1,173 @@
+/*
+ * memset, memcpy and memmove, which GCC expects to find.
+ *
+ * These get used for arena clears, framebuffer fills and struct copies all
+ * over, so they work a word at a time where they can, and four words at a
+ * time in their main loops, which GCC turns into LDM/STM.
+ *
+ * They live in RAM with the rest of the latency-sensitive code.  The SRAM
+ * image is loaded at the base of ROM, which appears at address zero until
+ * remap_sram runs, so calls made before then -- from crt0, say -- run the
+ * same code from flash.  That only works because these make no absolute
+ * references to .data, which hasn't been copied yet; keep it that way.
+ *
+ * Note that the BUILD file stops GCC from recognizing the byte loops below as
+ * memset and memcpy, and compiling them into calls to themselves.
+ */
+
+#include "runtime/memory.h"
+
+#include <cstdint>
+
+#include "etl/attribute_macros.h"
+
+// Words may alias whatever type the caller's bytes really are.
+typedef std::uint32_t __attribute__((may_alias)) Word;
+
+// A word at an address that may not be aligned.  The Cortex-M4 can load and
+// store these with plain LDR and STR, at the cost of an extra bus cycle or so.
+struct __attribute__((packed, may_alias)) UnalignedWord {
+  Word w;
+};
+
+static inline bool is_aligned(void const *p) {
+  return (reinterpret_cast<std::uintptr_t>(p) & (sizeof(Word) - 1)) == 0;
+}
+
+ETL_SECTION(".ramcode")
+void *RUNTIME_MEMORY(memset)(void *s, int c, unsigned n) {
+  auto dst = static_cast<unsigned char *>(s);
+  auto const byte = static_cast<unsigned char>(c);
+
+  while (n && !is_aligned(dst)) {
+    *dst++ = byte;
+    --n;
+  }
+
+  auto const fill = Word(byte) * 0x01010101u;
+  auto wdst = reinterpret_cast<Word *>(dst);
+  for (; n >= 4 * sizeof(Word); n -= 4 * sizeof(Word)) {
+    wdst[0] = fill;
+    wdst[1] = fill;
+    wdst[2] = fill;
+    wdst[3] = fill;
+    wdst += 4;
+  }
+  for (; n >= sizeof(Word); n -= sizeof(Word)) {
+    *wdst++ = fill;
+  }
+
+  dst = reinterpret_cast<unsigned char *>(wdst);
+  while (n--) *dst++ = byte;
+
+  return s;
+}
+
+/*
+ * Copies from low addresses to high.  Once the destination is aligned, the
+ * source is read a word at a time too: with aligned loads if it happens to be
+ * aligned as well, and unaligned loads if not.
+ */
+ETL_SECTION(".ramcode")
+static void copy_forward(unsigned char *dst,
+                         unsigned char const *src,
+                         unsigned n) {
+  while (n && !is_aligned(dst)) {
+    *dst++ = *src++;
+    --n;
+  }
+
+  auto wdst = reinterpret_cast<Word *>(dst);
+  if (is_aligned(src)) {
+    auto wsrc = reinterpret_cast<Word const *>(src);
+    for (; n >= 4 * sizeof(Word); n -= 4 * sizeof(Word)) {
+      auto const a = wsrc[0], b = wsrc[1], c = wsrc[2], d = wsrc[3];
+      wdst[0] = a;
+      wdst[1] = b;
+      wdst[2] = c;
+      wdst[3] = d;
+      wsrc += 4;
+      wdst += 4;
+    }
+    for (; n >= sizeof(Word); n -= sizeof(Word)) {
+      *wdst++ = *wsrc++;
+    }
+    src = reinterpret_cast<unsigned char const *>(wsrc);
+  } else {
+    auto usrc = reinterpret_cast<UnalignedWord const *>(src);
+    for (; n >= sizeof(Word); n -= sizeof(Word)) {
+      *wdst++ = (usrc++)->w;
+    }
+    src = reinterpret_cast<unsigned char const *>(usrc);
+  }
+
+  dst = reinterpret_cast<unsigned char *>(wdst);
+  while (n--) *dst++ = *src++;
+}
+
+/*
+ * The same, from high addresses to low, for overlapping moves to higher
+ * addresses.  dst and src point just past the ends of the regions.
+ */
+ETL_SECTION(".ramcode")
+static void copy_backward(unsigned char *dst,
+                          unsigned char const *src,
+                          unsigned n) {
+  while (n && !is_aligned(dst)) {
+    *--dst = *--src;
+    --n;
+  }
+
+  auto wdst = reinterpret_cast<Word *>(dst);
+  if (is_aligned(src)) {
+    auto wsrc = reinterpret_cast<Word const *>(src);
+    for (; n >= 4 * sizeof(Word); n -= 4 * sizeof(Word)) {
+      wsrc -= 4;
+      wdst -= 4;
+      auto const a = wsrc[0], b = wsrc[1], c = wsrc[2], d = wsrc[3];
+      wdst[0] = a;
+      wdst[1] = b;
+      wdst[2] = c;
+      wdst[3] = d;
+    }
+    for (; n >= sizeof(Word); n -= sizeof(Word)) {
+      *--wdst = *--wsrc;
+    }
+    src = reinterpret_cast<unsigned char const *>(wsrc);
+  } else {
+    auto usrc = reinterpret_cast<UnalignedWord const *>(src);
+    for (; n >= sizeof(Word); n -= sizeof(Word)) {
+      *--wdst = (--usrc)->w;
+    }
+    src = reinterpret_cast<unsigned char const *>(usrc);
+  }
+
+  dst = reinterpret_cast<unsigned char *>(wdst);
+  while (n--) *--dst = *--src;
+}
+
+ETL_SECTION(".ramcode")
+void *RUNTIME_MEMORY(memcpy)(void *d, void const *s, unsigned n) {
+  copy_forward(static_cast<unsigned char *>(d),
+               static_cast<unsigned char const *>(s),
+               n);
+  return d;
+}
+
+/*
+ * Copying toward the destination would overwrite source bytes before they'd
+ * been read.  So this copies away from it: forward if the destination is
+ * below the source, backward if above.
+ */
+ETL_SECTION(".ramcode")
+void *RUNTIME_MEMORY(memmove)(void *d, void const *s, unsigned n) {
+  auto const dst = static_cast<unsigned char *>(d);
+  auto const src = static_cast<unsigned char const *>(s);
+
+  if (dst <= src || dst >= src + n) {
+    copy_forward(dst, src, n);
+  } else {
+    copy_backward(dst + n, src + n, n);
+  }
+  return d;
+}
@@ -0,0 +1,23 @@
+#ifndef RUNTIME_MEMORY_H
+#define RUNTIME_MEMORY_H
+
+/*
+ * The runtime's memset, memcpy and memmove.
+ *
+ * On a host these would clash with libc's, so they take other names there,
+ * and can be tested against libc's side by side.
+ */
+
+#ifdef BUILDING_ON_HOST
+#define RUNTIME_MEMORY(name) runtime_##name
+#else
+#define RUNTIME_MEMORY(name) name
+#endif
+
+extern "C" {
+  void *RUNTIME_MEMORY(memset)(void *, int, unsigned);
+  void *RUNTIME_MEMORY(memcpy)(void *, void const *, unsigned);
+  void *RUNTIME_MEMORY(memmove)(void *, void const *, unsigned);
+}
+
+#endif  // RUNTIME_MEMORY_H
@@ -0,0 +1,50 @@
+import cobble
+
+class RaycastMapConverter(cobble.Target):
+  def __init__(self, loader, package, name,
+               environment,
+               map_name):
+    super(RaycastMapConverter, self).__init__(loader, package, name)
+    self.environment = environment
+    self.map_name = map_name
+    self.leaf = True
+
+  def _derive_local(self, unused):
+    return self.package.project.named_envs[self.environment]
+
+  def _using_and_products(self, env_local): 
+    source_map = self.package.inpath(self.map_name + '.map')
+    header, source = [self.package.genpath(self.map_name + '.' + ext)
+                           for ext in ['h', 'cc']]
+
+    script = self.project.inpath('demo', 'raycast', 'process_map.rb')
+    converter = {
+      'outputs': [header, source],
+      'rule': 'convert_raycast_map',
+      'inputs': [source_map],
+      'implicit': [script],
+      'variables': {
+        'script': script,
+        'outputdir': self.package.genpath(),
+        'name': self.map_name,
+      },
+    }
+
+    using = cobble.env.make_appending_delta(
+      __order_only__ = [ header ],
+      cxx_flags = [ '-I' + self.project.genpath() ],
+    )
+
+    return (using, [converter])
+
+
+package_verbs = {
+  'convert_raycast_map': RaycastMapConverter,
+}
+
+ninja_rules = {
+  'convert_raycast_map': {
+    'command': '$script $in $outputdir $name',
+    'description': 'MAP $in',
+  },
+}
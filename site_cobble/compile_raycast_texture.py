@@ -1,12 +1,16 @@
 import cobble
 
+from host_tool import host_tool_product
+
 class RaycastTextureConverter(cobble.Target):
   def __init__(self, loader, package, name,
                environment,
-               tex_name):
+               tex_name,
+               packed = False):
     super(RaycastTextureConverter, self).__init__(loader, package, name)
     self.environment = environment
     self.tex_name = tex_name
+    self.packed = packed
     self.leaf = True
 
   def _derive_local(self, unused):
@@ -17,16 +21,22 @@ class RaycastTextureConverter(cobble.Target):
     header, source = [self.package.genpath(self.tex_name + '.' + ext)
                            for ext in ['h', 'cc']]
 
-    script = self.project.inpath('demo', 'raycast', 'process_textures.rb')
+    # The converter is a host program, built from source as part of the build
+    # so that changes to it regenerate the textures.
+    tool_source = self.project.inpath('demo', 'raycast', 'process_textures.cc')
+    tool = self.package.genpath('process_textures')
+    compiler = host_tool_product(tool_source, tool)
+
     converter = {
       'outputs': [header, source],
       'rule': 'convert_raycast_texture',
       'inputs': [pnm],
-      'implicit': [script],
+      'implicit': [tool],
       'variables': {
-        'script': script,
+        'tool': tool,
         'outputdir': self.package.genpath(),
         'name': self.tex_name,
+        'flags': '--4bpp' if self.packed else '',
       },
     }
 
@@ -35,7 +45,7 @@ class RaycastTextureConverter(cobble.Target):
       cxx_flags = [ '-I' + self.project.genpath() ],
     )
 
-    return (using, [converter])
+    return (using, [compiler, converter])
 
 
 package_verbs = {
@@ -44,7 +54,7 @@ package_verbs = {
 
 ninja_rules = {
   'convert_raycast_texture': {
-    'command': '$script $in $outputdir $name',
+    'command': '$tool $in $outputdir $name $flags',
     'description': 'TEX $in',
   },
 }
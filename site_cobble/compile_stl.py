@@ -1,12 +1,14 @@
 import cobble
 
+from host_tool import host_tool_product
+
 class StlCompiler(cobble.Target):
   def __init__(self, loader, package, name,
                environment,
-               stl_file = []):
+               stl_files = []):
     super(StlCompiler, self).__init__(loader, package, name)
     self.environment = environment
-    self.stl_file = stl_file
+    self.stl_files = stl_files
     self.leaf = True
 
   def _derive_local(self, unused):
@@ -16,14 +18,19 @@ class StlCompiler(cobble.Target):
     header, source = [self.package.genpath('model.' + ext)
                         for ext in ['h', 'cc']]
 
-    script = self.package.inpath('stlmunge.rb')
+    # Like the texture converter, the mesh compiler is a host program built
+    # from source here, so that changes to it regenerate the models.
+    tool_source = self.project.inpath('demo', 'rook', 'stlmunge.cc')
+    tool = self.package.genpath('stlmunge')
+    tool_compiler = host_tool_product(tool_source, tool)
+
     compiler = {
       'outputs': [header, source],
       'rule': 'compile_stl',
-      'inputs': [self.package.inpath(self.stl_file)],
-      'implicit': [script],
+      'inputs': [self.package.inpath(f) for f in self.stl_files],
+      'implicit': [tool],
       'variables': {
-        'stlmunge': 'ruby ' + script,
+        'tool': tool,
         'outputdir': self.package.genroot,
       },
     }
@@ -32,7 +39,7 @@ class StlCompiler(cobble.Target):
       __order_only__ = [ header ],
     )
 
-    return (using, [compiler])
+    return (using, [tool_compiler, compiler])
 
 
 package_verbs = {
@@ -41,7 +48,7 @@ package_verbs = {
 
 ninja_rules = {
   'compile_stl': {
-    'command': '$stlmunge $outputdir < $in',
+    'command': '$tool $outputdir $in',
     'description': 'STL $in',
   },
 }
@@ -0,0 +1,24 @@
+"""Builds small C++ programs that run on the build machine, such as asset
+converters, from a single source file.
+
+Plugins that need one call host_tool_product for the build product, and list
+the tool as an implicit input of whatever runs it.  The rule is shared, so
+every host tool is built with the same flags.
+"""
+
+def host_tool_product(source, tool):
+  return {
+    'outputs': [tool],
+    'rule': 'compile_host_tool',
+    'inputs': [source],
+  }
+
+
+package_verbs = {}
+
+ninja_rules = {
+  'compile_host_tool': {
+    'command': 'c++ -std=gnu++11 -O2 -Wall -Werror -o $out $in',
+    'description': 'HOSTCXX $out',
+  },
+}